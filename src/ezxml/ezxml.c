@@ -34,10 +34,21 @@
 #include <sys/mman.h>
 #endif // EZXML_NOMMAP
 #include <sys/stat.h>
+#if defined(__GNUC__) && defined(__SSE2__) && ! defined(EZXML_NOSIMD)
+#define EZXML_SIMD
+#include <stdint.h>
+#include <immintrin.h>
+#endif // EZXML_NOSIMD
 #include "ezxml.h"
 
 #define EZXML_WS   "\t\r\n "  // whitespace
 #define EZXML_ERRL 128        // maximum error string length
+#ifndef EZXML_SLABSIZE
+#define EZXML_SLABSIZE 65536  // size of the slabs parsed tags are allocated in
+#endif
+#ifndef EZXML_SPAN
+#define EZXML_SPAN 4096       // shortest character content left in place by
+#endif                        // ezxml_parse_str_ro() or ezxml_parse_str_lazy()
 
 typedef struct ezxml_root *ezxml_root_t;
 struct ezxml_root {       // additional data for the root tag
@@ -50,9 +61,29 @@ struct ezxml_root {       // additional data for the root tag
     char *e;              // end of work area
     char **ent;           // general entities (ampersand sequences)
     char ***attr;         // default attributes
+    int *dhash;           // 1 + index in attr of each tag name, hashed by name
+    size_t dhash_size;    // size of dhash, a power of 2, or 0 for linear search
     char ***pi;           // processing instructions
     short standalone;     // non-zero if <?xml standalone="yes"?>
     char err[EZXML_ERRL]; // error string
+    struct ezxml_span {   // character content left in the read-only data
+        size_t off;       // offset of its placeholder from s
+        const char *txt;  // the character content
+        size_t len;       // and its length
+    } *span;
+    size_t nspan;         // number of spans
+    size_t ispan;         // next span to be claimed by ezxml_char_content()
+    short lazy;           // non-zero if spans are decoded by ezxml_txt_decode()
+    struct ezxml_slab {   // arena parsed tags and attribute lists live in
+        struct ezxml_slab *next;
+        size_t used, size;
+    } *slab;
+    char **abuf;          // attribute list of the tag being parsed
+    char *aflg;           // and its list of which names/values are malloced
+    int asize;            // number of pointers abuf has room for
+    void *map;            // read-only mem map the spans point into
+    size_t map_len;       // length of read-only mem map
+    int map_malloced;     // map was malloced, free it instead of unmapping
 };
 
 char *EZXML_NIL[] = { NULL }; // empty, null terminated array of strings
@@ -73,6 +104,52 @@ ezxml_t ezxml_idx(ezxml_t xml, int idx)
     return xml;
 }
 
+// returns a hash of the given string
+static size_t ezxml_hash(const char *s)
+{
+    size_t h = 2166136261u; // FNV-1a
+
+    while (*s) h = (h ^ (unsigned char)*(s++)) * 16777619u;
+    return h;
+}
+
+// returns the index in root->attr of the default attribute list for the given
+// tag name, or -1 if there is none
+static int ezxml_dflt(ezxml_root_t root, const char *name)
+{
+    size_t m = root->dhash_size - 1, i;
+    int k;
+
+    if (! root->dhash_size) { // no hash table, search linearly
+        for (k = 0; root->attr[k] && strcmp(name, root->attr[k][0]); k++);
+        return (root->attr[k]) ? k : -1;
+    }
+    for (i = ezxml_hash(name) & m; (k = root->dhash[i]); i = (i + 1) & m)
+        if (! strcmp(name, root->attr[k - 1][0])) return k - 1;
+    return -1;
+}
+
+// adds the n-1th default attribute list in root->attr to the hash table,
+// growing the table so it is at most half full
+static void ezxml_dflt_add(ezxml_root_t root, int n)
+{
+    size_t m, i, l = root->dhash_size;
+    int k = n - 1;
+
+    if ((size_t)n * 2 > l) { // rehash everything
+        for (l = (l) ? l : 16; (size_t)n * 2 > l; l *= 2);
+        free(root->dhash);
+        if (! (root->dhash = calloc(l, sizeof(int)))) l = 0; // search linearly
+        root->dhash_size = l;
+        k = 0;
+    }
+    for (m = l - 1; l && k < n; k++) {
+        i = ezxml_hash(root->attr[k][0]) & m;
+        while (root->dhash[i]) i = (i + 1) & m; // linear probing
+        root->dhash[i] = k + 1;
+    }
+}
+
 // returns the value of the requested tag attribute or NULL if not found
 const char *ezxml_attr(ezxml_t xml, const char *attr)
 {
@@ -84,8 +161,7 @@ const char *ezxml_attr(ezxml_t xml, const char *attr)
     if (xml->attr[i]) return xml->attr[i + 1]; // found attribute
 
     while (root->xml.parent) root = (ezxml_root_t)root->xml.parent; // root tag
-    for (i = 0; root->attr[i] && strcmp(xml->name, root->attr[i][0]); i++);
-    if (! root->attr[i]) return NULL; // no matching default attributes
+    if ((i = ezxml_dflt(root, xml->name)) < 0) return NULL; // no defaults
     while (root->attr[i][j] && strcmp(attr, root->attr[i][j])) j += 3;
     return (root->attr[i][j]) ? root->attr[i][j + 1] : NULL; // found default
 }
@@ -138,9 +214,14 @@ ezxml_t ezxml_err(ezxml_root_t root, char *s, const char *err, ...)
 {
     va_list ap;
     int line = 1;
-    char *t, fmt[EZXML_ERRL];
+    size_t i;
+    const char *t, *e;
+    char fmt[EZXML_ERRL];
     
     for (t = root->s; t < s; t++) if (*t == '\n') line++;
+    for (i = 0; s && i < root->nspan && root->s + root->span[i].off < s; i++)
+        for (t = root->span[i].txt, e = t + root->span[i].len;
+             (t = memchr(t, '\n', e - t)); t++) line++; // lines left in place
     snprintf(fmt, EZXML_ERRL, "[error near line %d]: %s", line, err);
 
     va_start(ap, err);
@@ -150,117 +231,357 @@ ezxml_t ezxml_err(ezxml_root_t root, char *s, const char *err, ...)
     return &root->xml;
 }
 
-// Recursively decodes entity and character references and normalizes new lines
-// ent is a null terminated array of alternating entity names and values. set t
-// to '&' for general entity decoding, '%' for parameter entity decoding, 'c'
-// for cdata sections, ' ' for attribute normalization, or '*' for non-cdata
-// attribute normalization. Returns s, or if the decoded string is longer than
-// s, returns a malloced string that must be freed.
-char *ezxml_decode(char *s, char **ent, char t)
+#ifdef EZXML_SIMD
+#define EZXML_SCANMAX 8 // most characters ezxml_scan() can look for
+
+// returns a bit mask of the bytes in the aligned 16 byte block at p that are
+// one of the n characters in c or are null
+__attribute__((no_sanitize_address))
+static inline uint32_t ezxml_mask_sse2(const char *p, const __m128i *c,
+                                       size_t n)
 {
-    char *e, *r = s, *m = s;
-    long b, c, d, l;
+    __m128i v = _mm_load_si128((const __m128i *)p);
+    __m128i m = _mm_cmpeq_epi8(v, _mm_setzero_si128());
 
-    for (; *s; s++) { // normalize line endings
-        while (*s == '\r') {
-            *(s++) = '\n';
-            if (*s == '\n') memmove(s, (s + 1), strlen(s));
-        }
-    }
-    
-    for (s = r; ; ) {
-        while (*s && *s != '&' && (*s != '%' || t != '%') && !isspace(*s)) s++;
+    while (n--) m = _mm_or_si128(m, _mm_cmpeq_epi8(v, c[n]));
+    return _mm_movemask_epi8(m);
+}
 
-        if (! *s) break;
+// SSE2 version of ezxml_scan(). reads whole aligned blocks, which never cross
+// a page boundary, so it may look past the null terminator
+__attribute__((no_sanitize_address))
+static char *ezxml_scan_sse2(const char *s, const char *set)
+{
+    const char *p = (const char *)((uintptr_t)s & ~(uintptr_t)15);
+    __m128i c[EZXML_SCANMAX];
+    size_t n;
+    uint32_t b;
+
+    for (n = 0; set[n]; n++) c[n] = _mm_set1_epi8(set[n]);
+    if ((b = ezxml_mask_sse2(p, c, n) >> (s - p)))
+        return (char *)s + __builtin_ctz(b);
+    while (! (b = ezxml_mask_sse2(p += 16, c, n)));
+    return (char *)p + __builtin_ctz(b);
+}
+
+#ifdef __x86_64__
+// same as ezxml_mask_sse2() for an aligned 32 byte block
+__attribute__((no_sanitize_address, target("avx2")))
+static inline uint32_t ezxml_mask_avx2(const char *p, const __m256i *c,
+                                       size_t n)
+{
+    __m256i v = _mm256_load_si256((const __m256i *)p);
+    __m256i m = _mm256_cmpeq_epi8(v, _mm256_setzero_si256());
+
+    while (n--) m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, c[n]));
+    return _mm256_movemask_epi8(m);
+}
+
+// AVX2 version of ezxml_scan()
+__attribute__((no_sanitize_address, target("avx2")))
+static char *ezxml_scan_avx2(const char *s, const char *set)
+{
+    const char *p = (const char *)((uintptr_t)s & ~(uintptr_t)31);
+    __m256i c[EZXML_SCANMAX];
+    size_t n;
+    uint32_t b;
+
+    for (n = 0; set[n]; n++) c[n] = _mm256_set1_epi8(set[n]);
+    if ((b = ezxml_mask_avx2(p, c, n) >> (s - p)))
+        return (char *)s + __builtin_ctz(b);
+    while (! (b = ezxml_mask_avx2(p += 32, c, n)));
+    return (char *)p + __builtin_ctz(b);
+}
+#endif // __x86_64__
+
+// picks the fastest ezxml_scan() the cpu supports on first use
+static char *ezxml_scan_init(const char *s, const char *set);
+static char *(*ezxml_scan_impl)(const char *, const char *) = ezxml_scan_init;
+
+static char *ezxml_scan_init(const char *s, const char *set)
+{
+    ezxml_scan_impl = ezxml_scan_sse2;
+#ifdef __x86_64__
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) ezxml_scan_impl = ezxml_scan_avx2;
+#endif // __x86_64__
+    return ezxml_scan_impl(s, set);
+}
+#endif // EZXML_SIMD
+
+// returns the first character in s that is in set, or the null terminator if
+// none is. same as s + strcspn(s, set) but vectorized where possible. set is
+// at most EZXML_SCANMAX characters
+static char *ezxml_scan(const char *s, const char *set)
+{
+#ifdef EZXML_SIMD
+    return ezxml_scan_impl(s, set);
+#else
+    return (char *)s + strcspn(s, set);
+#endif // EZXML_SIMD
+}
+
+// output cursor for ezxml_decode(). r is the start of the decoded text and d
+// the write position. while decoding in place, e is the read position, which
+// the decoded text may not overrun. once that would happen the output moves
+// to a malloced buffer and e is the end of the allocated space
+typedef struct ezxml_dec {
+    char *r, *d, *e;
+    short m;   // non-zero if r is malloced
+    short err; // non-zero if memory allocation failed
+} *ezxml_dec_t;
+
+// makes room for n more bytes of output. returns non-zero on failure
+static int ezxml_dec_grow(ezxml_dec_t o, size_t n)
+{
+    size_t l = o->d - o->r, max = 2 * (l + n) + 1;
+    char *r;
+
+    if (o->err) return 1;
+    if (o->d + n <= o->e) return 0;
+    if (! (r = (o->m) ? realloc(o->r, max) : malloc(max))) return o->err = 1;
+    if (! o->m) memcpy(r, o->r, l);
+    o->r = r;
+    o->d = r + l;
+    o->e = r + max;
+    o->m = 1;
+    return 0;
+}
+
+// returns the set of characters that need decoding for the given decoding type
+static const char *ezxml_dec_rej(char t)
+{
+    return (t == 'c') ? "\r" : (t == '%') ? "&%\r" : (t == '&') ? "&\r"
+                                                     : "&\r\t\n\v\f";
+}
+
+// decodes s appending the result to o. top is non-zero if s is the string
+// being decoded in place, zero for entity replacement text
+static void ezxml_decode_r(ezxml_dec_t o, char *s, char **ent, char t, short top)
+{
+    const char *rej = ezxml_dec_rej(t);
+    char *e, u[16];
+    long b, c, d, n;
+
+    for (; ; ) {
+        n = ezxml_scan(s, rej) - s; // copy run needing no decoding
+        if (top && ! o->m) o->e = s + n;
+        if (ezxml_dec_grow(o, n)) return;
+        memmove(o->d, s, n);
+        o->d += n;
+        if (! *(s += n)) return;
+
+        e = s + 1;
+        u[0] = *s;
+        n = 1;
+        if (*s == '\r') { // normalize line endings
+            u[0] = (t == ' ' || t == '*') ? ' ' : '\n';
+            if (*e == '\n') e++;
+        }
+        else if (isspace(*s)) u[0] = ' '; // attribute normalization
         else if (t != 'c' && ! strncmp(s, "&#", 2)) { // character reference
             if (s[2] == 'x') c = strtol(s + 3, &e, 16); // base 16
             else c = strtol(s + 2, &e, 10); // base 10
-            if (! c || *e != ';') { s++; continue; } // not a character ref
-
-            if (c < 0x80) *(s++) = c; // US-ASCII subset
+            if (! c || *(e++) != ';') e = s + 1; // not a character ref
+            else if (c < 0x80) u[0] = c; // US-ASCII subset
             else { // multi-byte UTF-8 sequence
                 for (b = 0, d = c; d; d /= 2) b++; // number of bits in c
                 b = (b - 2) / 5; // number of bytes in payload
-                *(s++) = (0xFF << (7 - b)) | (c >> (6 * b)); // head
-                while (b) *(s++) = 0x80 | ((c >> (6 * --b)) & 0x3F); // payload
+                u[0] = (0xFF << (7 - b)) | (c >> (6 * b)); // head
+                while (b) u[n++] = 0x80 | ((c >> (6 * --b)) & 0x3F); // payload
             }
-
-            memmove(s, strchr(s, ';') + 1, strlen(strchr(s, ';')));
         }
-        else if ((*s == '&' && (t == '&' || t == ' ' || t == '*')) ||
-                 (*s == '%' && t == '%')) { // entity reference
+        else if ((*s == '&' && t != '%') || (*s == '%' && t == '%')) { // entity
             for (b = 0; ent[b] && strncmp(s + 1, ent[b], strlen(ent[b]));
                  b += 2); // find entity in entity list
-
-            if (ent[b++]) { // found a match
-                if ((c = strlen(ent[b])) - 1 > (e = strchr(s, ';')) - s) {
-                    l = (d = (s - r)) + c + strlen(e); // new length
-                    r = (r == m) ? strcpy(malloc(l), r) : realloc(r, l);
-                    e = strchr((s = r + d), ';'); // fix up pointers
-                }
-
-                memmove(s + c, e + 1, strlen(e)); // shift rest of string
-                strncpy(s, ent[b], c); // copy in replacement text
+            if (ent[b]) { // found a match, decode the replacement text
+                s += strlen(ent[b]) + 1;
+                if (top && ! o->m) o->e = s;
+                ezxml_decode_r(o, ent[b + 1], ent, t, 0);
+                continue;
             }
-            else s++; // not a known entity
         }
-        else if ((t == ' ' || t == '*') && isspace(*s)) *(s++) = ' ';
-        else s++; // no decoding needed
+
+        s = e;
+        if (top && ! o->m) o->e = s;
+        if (ezxml_dec_grow(o, n)) return;
+        memcpy(o->d, u, n);
+        o->d += n;
+    }
+}
+
+// Decodes entity and character references and normalizes new lines in a
+// single pass. ent is a null terminated array of alternating entity names and
+// values. set t to '&' for general entity decoding, '%' for parameter entity
+// decoding, 'c' for cdata sections, ' ' for attribute normalization, or '*'
+// for non-cdata attribute normalization. Returns s, or if the decoded string
+// is longer than s, returns a malloced string that must be freed.
+char *ezxml_decode(char *s, char **ent, char t)
+{
+    struct ezxml_dec o = { s, s, s, 0, 0 };
+    char *c;
+
+    // fast path: nothing to decode
+    if (t != '*' && ! *ezxml_scan(s, ezxml_dec_rej(t))) return s;
+
+    ezxml_decode_r(&o, s, ent, t, 1);
+    if (ezxml_dec_grow(&o, 1)) { // out of memory
+        if (o.m) free(o.r);
+        return s;
     }
+    *o.d = '\0';
 
     if (t == '*') { // normalize spaces for non-cdata attributes
-        for (s = r; *s; s++) {
-            if ((l = strspn(s, " "))) memmove(s, s + l, strlen(s + l) + 1);
-            while (*s && *s != ' ') s++;
-        }
-        if (--s >= r && *s == ' ') *s = '\0'; // trim any trailing space
+        for (s = c = o.r; *s; s++)
+            if (*s != ' ' || (c != o.r && c[-1] != ' ')) *(c++) = *s;
+        if (c != o.r && c[-1] == ' ') c--; // trim any trailing space
+        *c = '\0';
     }
-    return r;
+    return o.r;
+}
+
+// Decodes the character content of a tag parsed by ezxml_parse_str_lazy()
+// that was left undecoded in the read-only data, and returns it. Returns the
+// existing character content for all other tags and NULL on failure.
+const char *ezxml_txt_decode(ezxml_t xml)
+{
+    ezxml_root_t root = (ezxml_root_t)xml;
+    char *s, *d;
+
+    if (! xml) return "";
+    if (! (xml->flags & EZXML_TXTR)) return xml->txt;
+    if (! memchr(xml->txt, '&', xml->len) &&
+        ! memchr(xml->txt, '\r', xml->len)) { // nothing to decode
+        xml->flags &= ~EZXML_TXTR; // leave it in place
+        return xml->txt;
+    }
+
+    while (root->xml.parent) root = (ezxml_root_t)root->xml.parent; // root tag
+    if (! (s = malloc(xml->len + 1))) return NULL;
+    memcpy(s, xml->txt, xml->len);
+    s[xml->len] = '\0';
+    if ((d = ezxml_decode(s, root->ent, '&')) != s) free(s);
+    xml->txt = d;
+    xml->flags = (xml->flags & ~(EZXML_TXTS | EZXML_TXTR)) | EZXML_TXTM;
+    return xml->txt;
+}
+
+// allocates n bytes in the document's arena, returns NULL on failure
+static void *ezxml_alloc(ezxml_root_t root, size_t n)
+{
+    struct ezxml_slab *p = root->slab;
+    size_t h = (sizeof(*p) + 15) & ~(size_t)15, l;
+
+    n = (n + 15) & ~(size_t)15; // keep everything 16 byte aligned
+    if (! p || p->used + n > p->size) { // start a new slab
+        l = (n + h > EZXML_SLABSIZE) ? n + h : EZXML_SLABSIZE;
+        if (! (p = malloc(l))) return NULL;
+        p->next = root->slab;
+        p->used = h;
+        p->size = l;
+        root->slab = p;
+    }
+    p->used += n;
+    return (char *)p + p->used - n;
 }
 
 // called when parser finds start of new tag
 void ezxml_open_tag(ezxml_root_t root, char *name, char **attr)
 {
-    ezxml_t xml = root->cur;
+    ezxml_t xml = root->cur, child;
     
-    if (xml->name) xml = ezxml_add_child(xml, name, strlen(xml->txt));
+    if (xml->name) {
+        ezxml_txt_decode(xml); // offsets are into decoded character content
+        if ((child = ezxml_alloc(root, sizeof(struct ezxml)))) {
+            memset(child, '\0', sizeof(struct ezxml));
+            child->name = name;
+            child->attr = EZXML_NIL;
+            child->txt = "";
+            child->flags = EZXML_TAGA;
+            xml = ezxml_insert(child, xml, ezxml_txt_len(xml));
+        }
+        else xml = ezxml_add_child(xml, name, ezxml_txt_len(xml));
+    }
     else xml->name = name; // first open tag
 
     xml->attr = attr;
+    if (attr != EZXML_NIL) ezxml_set_flag(xml, EZXML_ATTRA); // in the arena
     root->cur = xml; // update tag insertion point
 }
 
-// called when parser finds character content between open and closing tag
+// returns the size of the buffer holding character content of length n - 1
+// that is being appended to
+static size_t ezxml_txt_cap(size_t n)
+{
+    size_t c = EZXML_BUFSIZE;
+
+    while (c < n) c *= 2;
+    return c;
+}
+
+// called when parser finds character content between open and closing tag. t
+// is the ezxml_decode() decoding type, or '\0' if s needs no decoding
 void ezxml_char_content(ezxml_root_t root, char *s, size_t len, char t)
 {
     ezxml_t xml = root->cur;
+    struct ezxml_span *p = NULL;
     char *m = s;
-    size_t l;
+    size_t l, c;
 
     if (! xml || ! xml->name || ! len) return; // sanity check
 
-    s[len] = '\0'; // null terminate text (calling functions anticipate this)
-    len = strlen(s = ezxml_decode(s, root->ent, t)) + 1;
+    while (root->ispan < root->nspan &&
+           root->s + root->span[root->ispan].off < s) root->ispan++;
+    if (root->ispan < root->nspan && root->s + root->span[root->ispan].off == s)
+        p = &root->span[root->ispan++]; // placeholder for read-only data
+
+    if (p) { // character content is the span
+        s = (char *)p->txt;
+        len = p->len;
+    }
+    else {
+        s[len] = '\0'; // null terminate text (calling functions anticipate this)
+        if (t) len = strlen(s = ezxml_decode(s, root->ent, t));
+    }
 
-    if (! *(xml->txt)) xml->txt = s; // initial character content
+    if (! *(xml->txt)) { // initial character content
+        xml->txt = s;
+        xml->len = len;
+        if (p) ezxml_set_flag(xml, (root->lazy) ? EZXML_TXTS | EZXML_TXTR
+                                                : EZXML_TXTS);
+    }
     else { // allocate our own memory and make a copy
-        xml->txt = (xml->flags & EZXML_TXTM) // allocate some space
-                   ? realloc(xml->txt, (l = strlen(xml->txt)) + len)
-                   : strcpy(malloc((l = strlen(xml->txt)) + len), xml->txt);
-        strcpy(xml->txt + l, s); // add new char content
-        if (s != m) free(s); // free s if it was malloced by ezxml_decode()
+        ezxml_txt_decode(xml);
+        l = ezxml_txt_len(xml);
+        c = ezxml_txt_cap(l + len + 1); // grow geometrically while appending
+        if (! (xml->flags & EZXML_TXTA) || c > ezxml_txt_cap(l + 1))
+            xml->txt = (xml->flags & EZXML_TXTM) // allocate some space
+                       ? realloc(xml->txt, c)
+                       : memcpy(malloc(c), xml->txt, l);
+        memcpy(xml->txt + l, s, len); // add new char content
+        xml->txt[xml->len = l + len] = '\0';
+        xml->flags = (xml->flags & ~EZXML_TXTS) | EZXML_TXTA;
+        if (! p && s != m) free(s); // free s if it was malloced by ezxml_decode()
     }
 
-    if (xml->txt != m) ezxml_set_flag(xml, EZXML_TXTM);
+    if (xml->txt != m && ! (xml->flags & EZXML_TXTS))
+        ezxml_set_flag(xml, EZXML_TXTM);
 }
 
 // called when parser finds closing tag
 ezxml_t ezxml_close_tag(ezxml_root_t root, char *name, char *s)
 {
-    if (! root->cur || ! root->cur->name || strcmp(name, root->cur->name))
+    ezxml_t xml = root->cur;
+    char *t;
+
+    if (! xml || ! xml->name || strcmp(name, xml->name))
         return ezxml_err(root, s, "unexpected closing tag </%s>", name);
 
-    root->cur = root->cur->parent;
+    if (xml->flags & EZXML_TXTA) { // character content is complete, trim it
+        if ((t = realloc(xml->txt, xml->len + 1))) xml->txt = t;
+        xml->flags &= ~EZXML_TXTA;
+    }
+    root->cur = xml->parent;
     return NULL;
 }
 
@@ -367,7 +688,8 @@ short ezxml_internal_dtd(ezxml_root_t root, char *s, size_t len)
             if (! *t) { ezxml_err(root, t, "unclosed <!ATTLIST"); break; }
             if (*(s = t + strcspn(t, EZXML_WS ">")) == '>') continue;
             else *s = '\0'; // null terminate tag name
-            for (i = 0; root->attr[i] && strcmp(n, root->attr[i][0]); i++);
+            if ((i = ezxml_dflt(root, t)) < 0) // not seen yet, goes at the end
+                for (i = 0; root->attr[i]; i++);
 
             for (s++; *(n = s + strspn(s, EZXML_WS)) && *n != '>'; s++) {
                 if (*(s = n + strcspn(n, EZXML_WS))) *s = '\0'; // attr name
@@ -399,6 +721,7 @@ short ezxml_internal_dtd(ezxml_root_t root, char *s, size_t len)
                     root->attr[i] = malloc(2 * sizeof(char *));
                     root->attr[i][0] = t; // set tag name
                     root->attr[i][1] = (char *)(root->attr[i + 1] = NULL);
+                    ezxml_dflt_add(root, i + 1);
                 }
 
                 for (j = 1; root->attr[i][j]; j += 3); // find end of list
@@ -459,7 +782,9 @@ char *ezxml_str2utf8(char **s, size_t *len)
 }
 
 // frees a tag attribute list
-void ezxml_free_attr(char **attr) {
+// frees a tag attribute list, or if a is non-zero only the malloced names and
+// values in it, for lists in a document's arena
+void ezxml_free_attr(char **attr, short a) {
     int i = 0;
     char *m;
     
@@ -470,14 +795,40 @@ void ezxml_free_attr(char **attr) {
         if (m[i] & EZXML_NAMEM) free(attr[i * 2]);
         if (m[i] & EZXML_TXTM) free(attr[(i * 2) + 1]);
     }
+    if (a) return;
     free(m);
     free(attr);
 }
 
-// parse the given xml string and return an ezxml structure
-ezxml_t ezxml_parse_str(char *s, size_t len)
+// returns the attribute list of the tag being parsed, with room for the l/2th
+// attribute
+static char **ezxml_attr_buf(ezxml_root_t root, int l)
+{
+    if (l + 4 > root->asize) { // grow the list
+        root->asize = (l + 4) * 2;
+        root->abuf = realloc(root->abuf, root->asize * sizeof(char *));
+        root->aflg = realloc(root->aflg, root->asize / 2 + 1);
+    }
+    root->abuf[l + 3] = root->aflg;
+    return root->abuf;
+}
+
+// copies the l/2 attributes of the tag being parsed into the document's arena
+// and returns the copy, or NULL on failure
+static char **ezxml_attr_copy(ezxml_root_t root, char **attr, int l)
+{
+    char **a = ezxml_alloc(root, (l + 2) * sizeof(char *) + l / 2 + 1);
+
+    if (! a) return NULL;
+    memcpy(a, attr, l * sizeof(char *));
+    a[l] = NULL; // null terminate list
+    a[l + 1] = memcpy(a + l + 2, attr[l + 1], l / 2 + 1);
+    return a;
+}
+
+// parses the given xml string into the given root tag
+static ezxml_t ezxml_parse_root(ezxml_root_t root, char *s, size_t len)
 {
-    ezxml_root_t root = (ezxml_root_t)ezxml_new(NULL);
     char q, e, *d, **attr, **a = NULL; // initialize a to avoid compile warning
     int l, i, j;
 
@@ -489,7 +840,7 @@ ezxml_t ezxml_parse_str(char *s, size_t len)
     e = s[len - 1]; // save end char
     s[len - 1] = '\0'; // turn end char into null terminator
 
-    while (*s && *s != '<') s++; // find first tag
+    s = ezxml_scan(s, "<"); // find first tag
     if (! *s) return ezxml_err(root, s, "root tag missing");
 
     for (; ; ) {
@@ -504,13 +855,10 @@ ezxml_t ezxml_parse_str(char *s, size_t len)
             while (isspace(*s)) *(s++) = '\0'; // null terminate tag name
   
             if (*s && *s != '/' && *s != '>') // find tag in default attr list
-                for (i = 0; (a = root->attr[i]) && strcmp(a[0], d); i++);
+                a = ((i = ezxml_dflt(root, d)) < 0) ? NULL : root->attr[i];
 
             for (l = 0; *s && *s != '/' && *s != '>'; l += 2) { // new attrib
-                attr = (l) ? realloc(attr, (l + 4) * sizeof(char *))
-                           : malloc(4 * sizeof(char *)); // allocate space
-                attr[l + 3] = (l) ? realloc(attr[l + 1], (l / 2) + 2)
-                                  : malloc(2); // mem for list of maloced vals
+                attr = ezxml_attr_buf(root, l); // allocate space
                 strcpy(attr[l + 3] + (l / 2), " "); // value is not malloced
                 attr[l + 2] = NULL; // null terminate list
                 attr[l + 1] = ""; // temporary attribute value
@@ -525,7 +873,7 @@ ezxml_t ezxml_parse_str(char *s, size_t len)
                         while (*s && *s != q) s++;
                         if (*s) *(s++) = '\0'; // null terminate attribute val
                         else {
-                            ezxml_free_attr(attr);
+                            ezxml_free_attr(attr, 1);
                             return ezxml_err(root, d, "missing %c", q);
                         }
 
@@ -538,11 +886,15 @@ ezxml_t ezxml_parse_str(char *s, size_t len)
                 }
                 while (isspace(*s)) s++;
             }
+            if (l && ! (attr = ezxml_attr_copy(root, attr, l))) {
+                ezxml_free_attr(root->abuf, 1);
+                return ezxml_err(root, d, "out of memory");
+            }
 
             if (*s == '/') { // self closing tag
                 *(s++) = '\0';
                 if ((*s && *s != '>') || (! *s && e != '>')) {
-                    if (l) ezxml_free_attr(attr);
+                    if (l) ezxml_free_attr(attr, 1);
                     return ezxml_err(root, d, "missing >");
                 }
                 ezxml_open_tag(root, d, attr);
@@ -554,7 +906,7 @@ ezxml_t ezxml_parse_str(char *s, size_t len)
                 *s = q;
             }
             else {
-                if (l) ezxml_free_attr(attr);
+                if (l) ezxml_free_attr(attr, 1);
                 return ezxml_err(root, d, "missing >"); 
             }
         }
@@ -595,8 +947,12 @@ ezxml_t ezxml_parse_str(char *s, size_t len)
         *s = '\0';
         d = ++s;
         if (*s && *s != '<') { // tag character content
-            while (*s && *s != '<') s++;
-            if (*s) ezxml_char_content(root, d, s - d, '&');
+            if (*(s = ezxml_scan(s, "<&\r")) == '<') q = '\0'; // no decoding
+            else { // find the end of text that needs decoding
+                s = ezxml_scan(s, "<");
+                q = '&';
+            }
+            if (*s) ezxml_char_content(root, d, s - d, q);
             else break;
         }
         else if (! *s) break;
@@ -607,12 +963,155 @@ ezxml_t ezxml_parse_str(char *s, size_t len)
     else return ezxml_err(root, d, "unclosed tag <%s>", root->cur->name);
 }
 
+// parse the given xml string and return an ezxml structure
+ezxml_t ezxml_parse_str(char *s, size_t len)
+{
+    return ezxml_parse_root((ezxml_root_t)ezxml_new(NULL), s, len);
+}
+
+// returns the first occurrence of the null terminated string p in s, which
+// ends at e, or NULL if not found
+static const char *ezxml_memstr(const char *s, const char *e, const char *p)
+{
+    size_t l = strlen(p);
+
+    for (; (s = memchr(s, *p, e - s)) && (size_t)(e - s) >= l; s++)
+        if (! memcmp(s, p, l)) return s;
+    return NULL;
+}
+
+// returns the end of the markup starting at s, or e if it is not terminated.
+// sets *st to non-zero if the markup is a start tag that is not self closing
+static const char *ezxml_ro_markup(const char *s, const char *e, short *st)
+{
+    const char *t = s + 1, *p = NULL;
+    short l = 0;
+
+    *st = 0;
+    if (e - s >= 4 && ! memcmp(s, "<!--", 4)) // comment
+        return (t = ezxml_memstr(s + 4, e, "-->")) ? t + 3 : e;
+    if (e - s >= 9 && ! memcmp(s, "<![CDATA[", 9)) // cdata
+        return (t = ezxml_memstr(s + 9, e, "]]>")) ? t + 3 : e;
+    if (e - s >= 2 && s[1] == '?') // processing instruction
+        return (t = ezxml_memstr(s + 2, e, "?>")) ? t + 2 : e;
+    if (e - s >= 2 && s[1] == '!') { // dtd, find > or ]> if there is a subset
+        for (; t < e; t++) {
+            if (*t == '[') l = 1;
+            else if (*t == '>' && ! l) return t + 1;
+            else if (*t == ']' && l) {
+                for (p = t + 1; p < e && isspace(*p); p++);
+                if (p < e && *p == '>') return p + 1;
+            }
+        }
+        return e;
+    }
+
+    for (; t < e && *t != '>'; t++) // tag, > may appear in attribute values
+        if ((*t == '"' || *t == '\'') && ! (t = memchr(t + 1, *t, e - t - 1)))
+            return e;
+    if (t == e) return e;
+    *st = (s[1] != '/' && t[-1] != '/');
+    return t + 1;
+}
+
+// Copies len bytes of xml data from s for ezxml_parse_str_ro() to parse,
+// leaving out character content that directly follows a start tag, needs no
+// decoding (unless root->lazy is set), and is at least EZXML_SPAN bytes long.
+// Each such span is replaced by a placeholder character and recorded in
+// root->span. Returns the malloced copy and sets *l to its length, or returns
+// NULL on failure.
+static char *ezxml_ro_copy(ezxml_root_t root, const char *s, size_t len,
+                           size_t *l)
+{
+    const char *e = s + len, *n, *t;
+    char *m = malloc(EZXML_BUFSIZE), *r;
+    size_t max = EZXML_BUFSIZE, c;
+    short st = 0; // non-zero if the last markup was a start tag
+    struct ezxml_span *p;
+
+    if (! m) return NULL;
+    for (*l = 0; s < e; s = n) {
+        if (*(t = s) == '<') n = ezxml_ro_markup(s, e, &st);
+        else if (! (n = memchr(s, '<', e - s))) n = e;
+        else if (st && n - s >= EZXML_SPAN && (root->lazy ||
+                 (! memchr(s, '&', n - s) && ! memchr(s, '\r', n - s)))) {
+            // leave character content in place
+            if (! (root->nspan & (root->nspan - 1))) { // grow span list
+                p = realloc(root->span, sizeof(*p) * (root->nspan ?
+                                                      2 * root->nspan : 1));
+                if (! p) { free(m); return NULL; }
+                root->span = p;
+            }
+            p = &root->span[root->nspan++];
+            p->off = *l;
+            p->txt = s;
+            p->len = n - s;
+            t = " "; // placeholder
+        }
+
+        c = (t == s) ? (size_t)(n - s) : 1;
+        for (; *l + c + 1 > max; max *= 2, m = r) // grow copy
+            if (! (r = realloc(m, 2 * max))) { free(m); return NULL; }
+        memcpy(m + *l, t, c);
+        *l += c;
+    }
+    m[*l] = '\0';
+    return m;
+}
+
+// parses s without modifying it, deferring the decoding of long character
+// content until ezxml_txt_decode() if lazy is non-zero
+static ezxml_t ezxml_parse_ro(const char *s, size_t len, short lazy)
+{
+    ezxml_root_t root = (ezxml_root_t)ezxml_new(NULL);
+    char *u = (char *)s, *m;
+
+    root->lazy = lazy;
+    if (len) u = ezxml_str2utf8(&u, &len); // convert utf-16 to utf-8
+    if (! (m = ezxml_ro_copy(root, (u) ? u : s, len, &len))) {
+        ezxml_free(&root->xml);
+        free(u);
+        return NULL;
+    }
+    ezxml_parse_root(root, m, len);
+    root->len = -1; // so we know to free the copy in ezxml_free()
+    root->u = u; // spans point into the utf-8 conversion if there is one
+    return &root->xml;
+}
+
+// Like ezxml_parse_str() but does not modify s. Markup and short character
+// content are parsed from a copy, long character content is left in place and
+// is not null terminated, see ezxml_txt_len(). s must not be modified or freed
+// before the ezxml structure is. Returns NULL on failure.
+ezxml_t ezxml_parse_str_ro(const char *s, size_t len)
+{
+    return ezxml_parse_ro(s, len, 0);
+}
+
+// Like ezxml_parse_str_ro() but long character content is left in place even
+// if it needs decoding. It has the EZXML_TXTR flag set until decoded by
+// ezxml_txt_decode(). Returns NULL on failure.
+ezxml_t ezxml_parse_str_lazy(const char *s, size_t len)
+{
+    return ezxml_parse_ro(s, len, 1);
+}
+
+// Like ezxml_parse_str() but takes ownership of s, which must have been
+// malloced. s is freed by ezxml_free(), or before returning NULL on failure.
+ezxml_t ezxml_parse_str_m(char *s, size_t len)
+{
+    ezxml_root_t root = (ezxml_root_t)ezxml_parse_str(s, len);
+
+    if (! root) { free(s); return NULL; }
+    root->len = -1; // so we know to free s in ezxml_free()
+    return &root->xml;
+}
+
 // Wrapper for ezxml_parse_str() that accepts a file stream. Reads the entire
 // stream into memory and then parses it. For xml files, use ezxml_parse_file()
 // or ezxml_parse_fd()
 ezxml_t ezxml_parse_fp(FILE *fp)
 {
-    ezxml_root_t root;
     size_t l, len = 0;
     char *s;
 
@@ -623,9 +1122,7 @@ ezxml_t ezxml_parse_fp(FILE *fp)
     } while (s && l == EZXML_BUFSIZE);
 
     if (! s) return NULL;
-    root = (ezxml_root_t)ezxml_parse_str(s, len);
-    root->len = -1; // so we know to free s in ezxml_free()
-    return &root->xml;
+    return ezxml_parse_str_m(s, len);
 }
 
 // A wrapper for ezxml_parse_str() that accepts a file descriptor. First
@@ -670,10 +1167,72 @@ ezxml_t ezxml_parse_file(const char *file)
     return xml;
 }
 
-// equivalent to ezxml_parse_file() but transparently decompresses
-// gzip-compressed files when that format is detected.  also works with
-// uncompressed files
-ezxml_t ezxml_parse_gzfile(const char *file)
+// mem maps fd read-only and parses it with ezxml_parse_ro()
+static ezxml_t ezxml_parse_fd_map(int fd, short lazy)
+{
+#ifndef EZXML_NOMMAP
+    ezxml_root_t root;
+    struct stat st;
+    size_t l;
+    void *m;
+
+    if (fd < 0 || fstat(fd, &st)) return NULL;
+    l = (st.st_size + sysconf(_SC_PAGESIZE) - 1) & ~(sysconf(_SC_PAGESIZE) -1);
+    if (l && (m = mmap(NULL, l, PROT_READ, MAP_SHARED, fd, 0)) != MAP_FAILED) {
+        madvise(m, l, MADV_SEQUENTIAL); // optimize for sequential access
+        if (! (root = (ezxml_root_t)ezxml_parse_ro(m, st.st_size, lazy))) {
+            munmap(m, l);
+            return NULL;
+        }
+        madvise(m, l, MADV_NORMAL); // put it back to normal
+        root->map = m;
+        root->map_len = l;
+        return &root->xml;
+    }
+#endif // EZXML_NOMMAP
+    return ezxml_parse_fd(fd);
+}
+
+// A wrapper for ezxml_parse_str_ro() that accepts a file descriptor. The file
+// is mem mapped read-only so its pages are shared with the page cache and other
+// processes mapping it rather than copied. If it can't be mapped, falls back to
+// ezxml_parse_fd(). Returns NULL on failure.
+ezxml_t ezxml_parse_fd_ro(int fd)
+{
+    return ezxml_parse_fd_map(fd, 0);
+}
+
+// a wrapper for ezxml_parse_fd_ro() that accepts a file name
+ezxml_t ezxml_parse_file_ro(const char *file)
+{
+    int fd = open(file, O_RDONLY, 0);
+    ezxml_t xml = ezxml_parse_fd_ro(fd);
+    
+    if (fd >= 0) close(fd);
+    return xml;
+}
+
+// A wrapper for ezxml_parse_str_lazy() that accepts a file descriptor. The file
+// is mem mapped read-only as by ezxml_parse_fd_ro(). If it can't be mapped,
+// falls back to ezxml_parse_fd(). Returns NULL on failure.
+ezxml_t ezxml_parse_fd_lazy(int fd)
+{
+    return ezxml_parse_fd_map(fd, 1);
+}
+
+// a wrapper for ezxml_parse_fd_lazy() that accepts a file name
+ezxml_t ezxml_parse_file_lazy(const char *file)
+{
+    int fd = open(file, O_RDONLY, 0);
+    ezxml_t xml = ezxml_parse_fd_lazy(fd);
+    
+    if (fd >= 0) close(fd);
+    return xml;
+}
+
+// reads a possibly gzip-compressed file into a malloced buffer and sets *len
+// to its length.  returns NULL on failure
+static char *ezxml_gzread(const char *file, size_t *len)
 {
     gzFile f;
     char *buf = NULL;;
@@ -681,7 +1240,6 @@ ezxml_t ezxml_parse_gzfile(const char *file)
     size_t alloc_size = 65536;
     size_t pos = 0;
     size_t l;
-    ezxml_root_t xml;
 
     f = gzopen(file, "rb");
     if(!f)
@@ -717,8 +1275,43 @@ ezxml_t ezxml_parse_gzfile(const char *file)
     }
     buf = newbuf;
 
-    xml = (ezxml_root_t) ezxml_parse_str(buf, pos);
-    xml->len = -1;	// tell ezxml_free() to free buf
+    *len = pos;
+    return buf;
+}
+
+// equivalent to ezxml_parse_file() but transparently decompresses
+// gzip-compressed files when that format is detected.  also works with
+// uncompressed files
+ezxml_t ezxml_parse_gzfile(const char *file)
+{
+    char *buf;
+    size_t len;
+
+    if(!(buf = ezxml_gzread(file, &len)))
+        return NULL;
+
+    return ezxml_parse_str_m(buf, len);	// ezxml_free() frees buf
+}
+
+// equivalent to ezxml_parse_file_lazy() but transparently decompresses
+// gzip-compressed files when that format is detected.  the decompressed
+// document is kept in memory until the ezxml structure is freed
+ezxml_t ezxml_parse_gzfile_lazy(const char *file)
+{
+    char *buf;
+    size_t len;
+    ezxml_root_t xml;
+
+    if(!(buf = ezxml_gzread(file, &len)))
+        return NULL;
+
+    xml = (ezxml_root_t) ezxml_parse_str_lazy(buf, len);
+    if(!xml) {
+        free(buf);
+        return NULL;
+    }
+    xml->map = buf;
+    xml->map_malloced = 1; // tell ezxml_free() to free buf
 
     return (ezxml_t) xml;
 }
@@ -756,7 +1349,7 @@ char *ezxml_toxml_r(ezxml_t xml, char **s, size_t *len, size_t *max,
 {
     int i, j;
     char *txt = (xml->parent) ? xml->parent->txt : "";
-    size_t off = 0;
+    size_t off = 0, l = ezxml_txt_len(xml->parent);
 
     // parent character content up to this tag
     *s = ezxml_ampencode(txt + start, xml->off - start, s, len, max, 0);
@@ -788,17 +1381,19 @@ char *ezxml_toxml_r(ezxml_t xml, char **s, size_t *len, size_t *max,
     }
     *len += sprintf(*s + *len, ">");
 
+    ezxml_txt_decode(xml); // children and data need decoded character content
     *s = (xml->child) ? ezxml_toxml_r(xml->child, s, len, max, 0, attr) //child
-                      : ezxml_ampencode(xml->txt, -1, s, len, max, 0);  //data
+                      : ezxml_ampencode(xml->txt, ezxml_txt_len(xml), s, len,
+                                        max, 0); // data
     
     while (*len + strlen(xml->name) + 4 > *max) // reallocate s
         *s = realloc(*s, *max += EZXML_BUFSIZE);
 
     *len += sprintf(*s + *len, "</%s>", xml->name); // close tag
 
-    while (txt[off] && off < xml->off) off++; // make sure off is within bounds
+    while (off < l && txt[off] && off < xml->off) off++; // off within bounds
     return (xml->ordered) ? ezxml_toxml_r(xml->ordered, s, len, max, off, attr)
-                          : ezxml_ampencode(txt + off, -1, s, len, max, 0);
+                          : ezxml_ampencode(txt + off, l - off, s, len, max, 0);
 }
 
 // Converts an ezxml structure back to xml. Returns a string of xml data that
@@ -841,16 +1436,40 @@ char *ezxml_toxml(ezxml_t xml)
     return realloc(s, len + 1);
 }
 
+// frees a single tag's own memory, not its children or siblings
+static void ezxml_free_tag(ezxml_t xml)
+{
+    ezxml_free_attr(xml->attr, xml->flags & EZXML_ATTRA); // tag attributes
+    if ((xml->flags & EZXML_TXTM)) free(xml->txt); // character content
+    if ((xml->flags & EZXML_NAMEM)) free(xml->name); // tag name
+    if (! (xml->flags & EZXML_TAGA)) free(xml); // not in the arena
+}
+
 // free the memory allocated for the ezxml structure
 void ezxml_free(ezxml_t xml)
 {
     ezxml_root_t root = (ezxml_root_t)xml;
+    struct ezxml_slab *slab = NULL, *p;
+    ezxml_t x, c;
     int i, j;
     char **a, *s;
 
     if (! xml) return;
-    ezxml_free(xml->child);
-    ezxml_free(xml->ordered);
+    // free everything reachable through child and ordered in one pass with
+    // constant stack: rotate each child up above its parent, ahead of the
+    // parent in the ordered chain, until the tag at hand has no children
+    for (x = xml; x; ) {
+        if ((c = x->child)) {
+            x->child = c->ordered;
+            c->ordered = x;
+            x = c;
+        }
+        else {
+            c = x->ordered;
+            if (x != xml) ezxml_free_tag(x);
+            x = c;
+        }
+    }
 
     if (! xml->parent) { // free root tag allocations
         for (i = 10; root->ent[i]; i += 2) // 0 - 9 are default entites (<>&"')
@@ -863,6 +1482,7 @@ void ezxml_free(ezxml_t xml)
             free(a);
         }
         if (root->attr[0]) free(root->attr); // free default attribute list
+        free(root->dhash); // default attribute lists hashed by tag name
 
         for (i = 0; root->pi[i]; i++) {
             for (j = 1; root->pi[i][j]; j++);
@@ -876,12 +1496,21 @@ void ezxml_free(ezxml_t xml)
         else if (root->len) munmap(root->m, root->len); // mem mapped xml data
 #endif // EZXML_NOMMAP
         if (root->u) free(root->u); // utf8 conversion
+        free(root->span); // character content left in read-only data
+        if (root->map_malloced) free(root->map); // malloced read-only data
+#ifndef EZXML_NOMMAP
+        else if (root->map) munmap(root->map, root->map_len); // read-only map
+#endif // EZXML_NOMMAP
+        free(root->abuf); // attribute list of the last tag parsed
+        free(root->aflg);
+        slab = root->slab; // arena, freed last since xml->attr may be in it
     }
 
-    ezxml_free_attr(xml->attr); // tag attributes
-    if ((xml->flags & EZXML_TXTM)) free(xml->txt); // character content
-    if ((xml->flags & EZXML_NAMEM)) free(xml->name); // tag name
-    free(xml);
+    ezxml_free_tag(xml);
+    for (; slab; slab = p) { // free the arena
+        p = slab->next;
+        free(slab);
+    }
 }
 
 // return parser error message or empty string if none
@@ -969,7 +1598,7 @@ ezxml_t ezxml_set_txt(ezxml_t xml, const char *txt)
 {
     if (! xml) return NULL;
     if (xml->flags & EZXML_TXTM) free(xml->txt); // existing txt was malloced
-    xml->flags &= ~EZXML_TXTM;
+    xml->flags &= ~(EZXML_TXTM | EZXML_TXTS | EZXML_TXTR | EZXML_TXTA);
     xml->txt = (char *)txt;
     return xml;
 }
@@ -979,8 +1608,17 @@ ezxml_t ezxml_set_txt(ezxml_t xml, const char *txt)
 ezxml_t ezxml_set_attr(ezxml_t xml, const char *name, const char *value)
 {
     int l = 0, c;
+    char **a;
 
     if (! xml) return NULL;
+    if (xml->flags & EZXML_ATTRA) { // move list out of the arena so it can grow
+        for (c = 0; xml->attr[c]; c += 2); // find end of attribute list
+        a = memcpy(malloc((c + 2) * sizeof(char *)), xml->attr,
+                   (c + 2) * sizeof(char *));
+        a[c + 1] = strdup(a[c + 1]); // list of which names/vals are malloced
+        xml->attr = a;
+        xml->flags &= ~EZXML_ATTRA;
+    }
     while (xml->attr[l] && strcmp(xml->attr[l], name)) l += 2;
     if (! xml->attr[l]) { // not found, add as new attribute
         if (! value) return xml; // nothing to do
@@ -1016,6 +1654,14 @@ ezxml_t ezxml_set_attr(ezxml_t xml, const char *name, const char *value)
     return xml;
 }
 
+// returns the length of the given tag's character content
+size_t ezxml_txt_len(ezxml_t xml)
+{
+    if (! xml) return 0;
+    return (xml->flags & (EZXML_TXTS | EZXML_TXTA)) ? xml->len
+                                                    : strlen(xml->txt);
+}
+
 // sets a flag for the given tag and returns the tag
 ezxml_t ezxml_set_flag(ezxml_t xml, short flag)
 {
@@ -38,6 +38,11 @@ extern "C" {
 #define EZXML_NAMEM   0x80 // name is malloced
 #define EZXML_TXTM    0x40 // txt is malloced
 #define EZXML_DUP     0x20 // attribute name and value are strduped
+#define EZXML_TXTS    0x10 // txt is read-only data and is not null terminated
+#define EZXML_TXTR    0x08 // txt has not been decoded, see ezxml_txt_decode()
+#define EZXML_TXTA    0x04 // txt is being appended to by the parser
+#define EZXML_TAGA    0x02 // tag is in its document's arena, see ezxml_cut()
+#define EZXML_ATTRA   0x01 // attr is in its document's arena
 
 typedef struct ezxml *ezxml_t;
 struct ezxml {
@@ -51,6 +56,7 @@ struct ezxml {
     ezxml_t child;   // head of sub tag list, NULL if none
     ezxml_t parent;  // parent tag, NULL if current tag is root tag
     short flags;     // additional information
+    size_t len;      // length of txt if EZXML_TXTS or EZXML_TXTA is set
 };
 
 // Given a string of xml data and its length, parses it and creates an ezxml
@@ -59,6 +65,10 @@ struct ezxml {
 // pass in the copy. Returns NULL on failure.
 ezxml_t ezxml_parse_str(char *s, size_t len);
 
+// Like ezxml_parse_str() but takes ownership of s, which must have been
+// malloced. s is freed by ezxml_free(), or before returning NULL on failure.
+ezxml_t ezxml_parse_str_m(char *s, size_t len);
+
 // A wrapper for ezxml_parse_str() that accepts a file descriptor. First
 // attempts to mem map the file. Failing that, reads the file into memory.
 // Returns NULL on failure.
@@ -67,10 +77,45 @@ ezxml_t ezxml_parse_fd(int fd);
 // a wrapper for ezxml_parse_fd() that accepts a file name
 ezxml_t ezxml_parse_file(const char *file);
 
+// Like ezxml_parse_str() but does not modify s. Markup and short character
+// content are parsed from a copy. Long character content that needs no
+// decoding is left in place, has the EZXML_TXTS flag set and is not null
+// terminated, use ezxml_txt_len() to find its length. s must not be modified
+// or freed before the ezxml structure is. Returns NULL on failure.
+ezxml_t ezxml_parse_str_ro(const char *s, size_t len);
+
+// A wrapper for ezxml_parse_str_ro() that accepts a file descriptor. The file
+// is mem mapped read-only so its pages are shared with the page cache instead
+// of being copied. Falls back to ezxml_parse_fd() if the file can't be mapped.
+// Returns NULL on failure.
+ezxml_t ezxml_parse_fd_ro(int fd);
+
+// a wrapper for ezxml_parse_fd_ro() that accepts a file name
+ezxml_t ezxml_parse_file_ro(const char *file);
+
+// Like ezxml_parse_str_ro() but long character content is left in place even
+// if it needs decoding, so only the markup is examined up front. Such content
+// has the EZXML_TXTR flag set until decoded by ezxml_txt_decode(). Returns NULL
+// on failure.
+ezxml_t ezxml_parse_str_lazy(const char *s, size_t len);
+
+// A wrapper for ezxml_parse_str_lazy() that accepts a file descriptor. The file
+// is mem mapped read-only as by ezxml_parse_fd_ro(). Falls back to
+// ezxml_parse_fd() if the file can't be mapped. Returns NULL on failure.
+ezxml_t ezxml_parse_fd_lazy(int fd);
+
+// a wrapper for ezxml_parse_fd_lazy() that accepts a file name
+ezxml_t ezxml_parse_file_lazy(const char *file);
+
 // equivalent to ezxml_parse_file() but transparently decompresses
 // gzip-compressed files when that format is detected.  also works with
 // uncompressed files
 ezxml_t ezxml_parse_gzfile(const char *file);
+
+// equivalent to ezxml_parse_file_lazy() but transparently decompresses
+// gzip-compressed files when that format is detected.  also works with
+// uncompressed files
+ezxml_t ezxml_parse_gzfile_lazy(const char *file);
     
 // Wrapper for ezxml_parse_str() that accepts a file stream. Reads the entire
 // stream into memory and then parses it. For xml files, use ezxml_parse_file()
@@ -95,6 +140,14 @@ ezxml_t ezxml_idx(ezxml_t xml, int idx);
 // returns the given tag's character content or empty string if none
 #define ezxml_txt(xml) ((xml) ? xml->txt : "")
 
+// returns the length of the given tag's character content
+size_t ezxml_txt_len(ezxml_t xml);
+
+// Returns the given tag's character content, first decoding it if it was left
+// undecoded by ezxml_parse_str_lazy(). The decoded content replaces the
+// original so this modifies the tag. Returns NULL on failure.
+const char *ezxml_txt_decode(ezxml_t xml);
+
 // returns the value of the requested tag attribute, or NULL if not found
 const char *ezxml_attr(ezxml_t xml, const char *attr);
 
@@ -152,7 +205,9 @@ ezxml_t ezxml_set_attr(ezxml_t xml, const char *name, const char *value);
 // sets a flag for the given tag and returns the tag
 ezxml_t ezxml_set_flag(ezxml_t xml, short flag);
 
-// removes a tag along with its subtags without freeing its memory
+// Removes a tag along with its subtags without freeing its memory. Tags created
+// by the parser are allocated in their document's arena, and remain valid
+// only until the document's root tag is freed, even after being cut.
 ezxml_t ezxml_cut(ezxml_t xml);
 
 // inserts an existing tag into an ezxml structure
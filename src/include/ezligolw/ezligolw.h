@@ -23,6 +23,8 @@
 #include <complex.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
 #include <ezligolw/ezxml.h>
 
 #ifdef __cplusplus
@@ -96,6 +98,154 @@ struct ligolw_table {
 		struct ligolw_table *table;
 		union ligolw_cell *cells;
 	} *rows;
+	/* if not NULL, the XML fragment the metadata was extracted from,
+	 * owned by the table and freed by ligolw_table_free() */
+	ezxml_t header;
+	/* hash table of column indexes by name, with -1 marking empty
+	 * slots, used by ligolw_table_get_column().  it has
+	 * column_index_mask + 1 slots.  NULL if it could not be built */
+	int *column_index;
+	unsigned column_index_mask;
+	/* the number of rows the rows array has room for */
+	int rows_capacity;
+	/* if not NULL, one block holding the cells of every row, row i's
+	 * starting at cells + i * n_columns, as built by
+	 * ligolw_table_parse_opts()'s default row builder */
+	union ligolw_cell *cells;
+	/* if not NULL, an unpacking plan a row call-back has compiled on
+	 * the first row to use for the rest, freed by ligolw_table_free() */
+	struct ligolw_unpacking_plan *plan;
+	/* while rows are being parsed with LIGOLW_TABLE_REUSE_ROW, the row
+	 * passed to every call of the row call-back, otherwise NULL */
+	struct ligolw_table_row *reused_row;
+	/* if not NULL, the blocks of memory holding the string and blob
+	 * data of the rows in cells, freed all at once by
+	 * ligolw_table_free().  see LIGOLW_TABLE_OWN_STRINGS */
+	struct ligolw_table_arena *arena;
+	/* if not 0, string cells of the rows in cells can also point into
+	 * the text of the document's Stream element.  see
+	 * LIGOLW_TABLE_BORROW_STRINGS */
+	int borrowed_strings;
+};
+
+
+struct ligolw_table_filter {
+	enum ligolw_table_filter_op {
+		LIGOLW_TABLE_FILTER_AND,
+		LIGOLW_TABLE_FILTER_OR,
+		LIGOLW_TABLE_FILTER_EQ,
+		LIGOLW_TABLE_FILTER_NE,
+		LIGOLW_TABLE_FILTER_LT,
+		LIGOLW_TABLE_FILTER_LE,
+		LIGOLW_TABLE_FILTER_GT,
+		LIGOLW_TABLE_FILTER_GE
+	} op;
+	/* comparisons:  the name of the column and the value it is
+	 * compared to, which is interpreted according to the column's
+	 * type */
+	const char *column;
+	union ligolw_cell value;
+	/* AND and OR:  the operands */
+	const struct ligolw_table_filter *a;
+	const struct ligolw_table_filter *b;
+};
+
+
+struct ligolw_table_options {
+	/* if not NULL, a NULL-terminated array of the names of the columns
+	 * to be converted.  other columns are skipped */
+	const char *const *columns;
+	/* if not NULL, rows for which the filter is false are skipped */
+	const struct ligolw_table_filter *filter;
+	/* ligolw_table_parse_batches():  rows per block, 0 for the
+	 * default */
+	int batch_size;
+	enum ligolw_table_flags {
+		LIGOLW_TABLE_FLAGS_NONE		= 0x00,
+		/* pass the same row to every row call-back, see
+		 * ligolw_table_parse_opts() */
+		LIGOLW_TABLE_REUSE_ROW		= 0x01,
+		/* blocks of rows can be passed to the call-back in any
+		 * order, from several threads at once, see
+		 * ligolw_table_parse_parallel() */
+		LIGOLW_TABLE_UNORDERED		= 0x02,
+		/* allocate the string and blob data of the default row
+		 * builder's rows cell by cell instead of in the table's
+		 * arena, so ligolw_cell_to_c() can take it, see
+		 * ligolw_table_parse_opts() */
+		LIGOLW_TABLE_OWN_STRINGS	= 0x04,
+		/* leave unescaped string values in the Stream's text,
+		 * terminated in place, instead of copying them, see
+		 * ligolw_table_parse_opts() */
+		LIGOLW_TABLE_BORROW_STRINGS	= 0x08,
+	} flags;
+	/* ligolw_table_parse_parallel():  number of threads, 0 for one
+	 * per on-line processor */
+	int n_threads;
+	/* ligolw_columnar_table_parse():  if not NULL, a NULL-terminated
+	 * array of the names of string columns to dictionary encode */
+	const char *const *dictionary;
+};
+
+
+struct ligolw_table_batch {
+	struct ligolw_table *table;
+	int n_rows;
+	/* the block's rows, and the cells of all of them in row order */
+	struct ligolw_table_row *rows;
+	union ligolw_cell *cells;
+	/* the index of the block's first row among all the rows passed to
+	 * the call-back */
+	int first_row;
+};
+
+
+struct ligolw_columnar_table {
+	const char *name;
+	int n_columns;
+	int n_rows;
+	struct ligolw_columnar_column {
+		const char *name;
+		enum ligolw_cell_type type;
+		/* n_rows values of the column's C type, or for string and
+		 * blob columns, the values concatenated, each followed by a
+		 * null character */
+		void *data;
+		/* string and blob columns:  the offset into data and the
+		 * length of each row's value.  NULL for numeric columns */
+		size_t *offsets;
+		size_t *lengths;
+		/* dictionary encoded string columns:  data, offsets and
+		 * lengths hold the column's n_values distinct values
+		 * instead of one per row, and codes gives the index of
+		 * each row's value among them.  NULL for other columns */
+		int *codes;
+		int n_values;
+	} *columns;
+};
+
+
+struct ligolw_index {
+	/* size and modification time, seconds and nanoseconds, of the
+	 * indexed file */
+	off_t size;
+	time_t mtime;
+	long mtime_nsec;
+	/* length of the prolog preceding the root element */
+	size_t prolog;
+	int n_entries;
+	struct ligolw_index_entry {
+		/* element type, and Name attribute or NULL if none */
+		const char *type;
+		const char *name;
+		/* entry of nearest indexed ancestor, or -1 if none */
+		int parent;
+		/* byte offset and length of the element, and the length of
+		 * its start tag */
+		off_t offset;
+		size_t length;
+		size_t head;
+	} *entries;
 };
 
 
@@ -106,13 +256,23 @@ const char *ligolw_strip_name(const char *, const char *);
 ezxml_t ligolw_elem_iter(ezxml_t, const char *, const char *);
 ezxml_t ligolw_elem_next(ezxml_t, const char *, const char *);
 
+struct ligolw_index *ligolw_index_build(const char *);
+int ligolw_index_write(const struct ligolw_index *, const char *);
+struct ligolw_index *ligolw_index_read(const char *, const char *);
+struct ligolw_index *ligolw_index_open(const char *);
+const struct ligolw_index_entry *ligolw_index_find_entry(const struct ligolw_index *, const char *, const char *);
+ezxml_t ligolw_index_load(const struct ligolw_index *, const char *, const char *, const char *);
+void ligolw_index_free(struct ligolw_index *);
+
 enum ligolw_cell_type ligolw_type_name_to_enum(const char *);
 const char *ligolw_type_enum_to_name(enum ligolw_cell_type);
 size_t ligolw_type_enum_to_size(enum ligolw_cell_type);
 union ligolw_cell *ligolw_cell_from_txt(union ligolw_cell *, enum ligolw_cell_type, const char *);
+union ligolw_cell *ligolw_cell_from_txtn(union ligolw_cell *, enum ligolw_cell_type, const char *, size_t);
 char *ligolw_cell_to_txt(union ligolw_cell, enum ligolw_cell_type);
 int ligolw_cell_to_c(union ligolw_cell *, enum ligolw_cell_type, void *);
 int ligolw_cell_string_copy(union ligolw_cell *, char *, size_t);
+int ligolw_cell_string_copy_keep(const union ligolw_cell *, char *, size_t);
 
 ezxml_t ligolw_array_get(ezxml_t, const char *);
 struct ligolw_array *ligolw_array_parse(ezxml_t);
@@ -121,12 +281,22 @@ void ligolw_array_free(struct ligolw_array *);
 int ligolw_table_default_row_callback(struct ligolw_table *, struct ligolw_table_row *, void *);
 ezxml_t ligolw_table_get(ezxml_t, const char *);
 struct ligolw_table *ligolw_table_parse(ezxml_t, int (*)(struct ligolw_table *, struct ligolw_table_row *, void *), void *);
+struct ligolw_table *ligolw_table_parse_opts(ezxml_t, const struct ligolw_table_options *, int (*)(struct ligolw_table *, struct ligolw_table_row *, void *), void *);
+struct ligolw_table *ligolw_table_parse_batches(ezxml_t, const struct ligolw_table_options *, int (*)(struct ligolw_table *, struct ligolw_table_batch *, void *), void *);
+struct ligolw_table *ligolw_table_parse_parallel(ezxml_t, const struct ligolw_table_options *, int (*)(struct ligolw_table *, struct ligolw_table_batch *, void *), void *);
+struct ligolw_table *ligolw_table_parse_gzfile(const char *, const char *, int (*)(struct ligolw_table *, struct ligolw_table_row *, void *), void *);
+struct ligolw_table *ligolw_table_parse_gzfile_opts(const char *, const char *, const struct ligolw_table_options *, int (*)(struct ligolw_table *, struct ligolw_table_row *, void *), void *);
 void ligolw_table_free_row_data(struct ligolw_table *, struct ligolw_table_row *);
+void ligolw_table_free_row(struct ligolw_table *, struct ligolw_table_row *);
 void ligolw_table_free(struct ligolw_table *);
 int ligolw_table_get_column(struct ligolw_table *, const char *, enum ligolw_cell_type *);
 int ligolw_table_print(FILE *, struct ligolw_table *);
 union ligolw_cell *ligolw_row_get_cell(const struct ligolw_table_row *, const char *, enum ligolw_cell_type *);
 
+struct ligolw_columnar_table *ligolw_columnar_table_parse(ezxml_t, const struct ligolw_table_options *);
+void ligolw_columnar_table_free(struct ligolw_columnar_table *);
+struct ligolw_columnar_column *ligolw_columnar_table_get_column(const struct ligolw_columnar_table *, const char *);
+
 
 struct ligolw_unpacking_spec {
 	const char *name;
@@ -137,9 +307,16 @@ struct ligolw_unpacking_spec {
 		LIGOLW_COLUMN_FLAGS_NONE	= 0x00,
 		LIGOLW_COLUMN_FLAGS_REQUIRED	= 0x01,
 	} flags;
+	/* if not 0, dest is a char array of this many bytes, and a string
+	 * column's value is copied into it, truncated if needed and
+	 * null-terminated, instead of its address being stored */
+	size_t capacity;
 };
 
 int ligolw_table_unpack_row(struct ligolw_table *, struct ligolw_table_row, struct ligolw_unpacking_spec *);
+struct ligolw_unpacking_plan *ligolw_unpacking_plan_new(struct ligolw_table *, const struct ligolw_unpacking_spec *, const void *, int *);
+int ligolw_unpacking_plan_apply(const struct ligolw_unpacking_plan *, struct ligolw_table_row *, void *);
+void ligolw_unpacking_plan_free(struct ligolw_unpacking_plan *);
 
 const char *ligolw_time_parse(ezxml_t, const char **);
 ezxml_t ligolw_time_get(ezxml_t, const char *);
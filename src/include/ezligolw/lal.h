@@ -30,6 +30,7 @@ extern "C" {
 
 
 int ligolw_lal_table_unpack_row(struct ligolw_table *, struct ligolw_table_row, struct ligolw_unpacking_spec *);
+int ligolw_lal_table_unpack_row_plan(struct ligolw_table *, struct ligolw_table_row *, struct ligolw_unpacking_spec *, void *);
 
 
 int ligolw_sim_burst_row_callback(struct ligolw_table *, struct ligolw_table_row *, void *);
@@ -39,6 +40,7 @@ int ligolw_sngl_inspiral_row_callback(struct ligolw_table *, struct ligolw_table
 int ligolw_time_slide_row_callback(struct ligolw_table *, struct ligolw_table_row *, void *);
 
 void *ligolw_lal_table_get(ezxml_t, const char *, int (struct ligolw_table *, struct ligolw_table_row *, void *));
+void *ligolw_lal_table_get_from_file(const char *, const char *, int (struct ligolw_table *, struct ligolw_table_row *, void *));
 
 
 REAL8FrequencySeries *ligolw_REAL8FrequencySeries_parse(ezxml_t);
@@ -31,7 +31,7 @@ int ligolw_sim_burst_row_callback(struct ligolw_table *table, struct ligolw_tabl
 	SimBurst *new = XLALCreateSimBurst();
 	struct ligolw_unpacking_spec sim_burst_basic[] = {
 		{"process:process_id", &new->process_id, NULL, ligolw_cell_type_int_8s, LIGOLW_COLUMN_FLAGS_REQUIRED},
-		{"waveform", NULL, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED},
+		{"waveform", new->waveform, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED, LIGOMETA_WAVEFORM_MAX},
 		{"ra", &new->ra, NULL, ligolw_cell_type_real_8, LIGOLW_COLUMN_FLAGS_REQUIRED},
 		{"dec", &new->dec, NULL, ligolw_cell_type_real_8, LIGOLW_COLUMN_FLAGS_REQUIRED},
 		{"psi", &new->psi, NULL, ligolw_cell_type_real_8, LIGOLW_COLUMN_FLAGS_REQUIRED},
@@ -84,16 +84,10 @@ int ligolw_sim_burst_row_callback(struct ligolw_table *table, struct ligolw_tabl
 		goto error;
 	}
 
-	/* unpack the base columns.  have to do the strings manually
-	 * because they get copied by value rather than reference. */
-	if(ligolw_lal_table_unpack_row(table, *row, sim_burst_basic))
+	/* unpack the base columns.  strings are copied into the structure's arrays */
+	if(ligolw_lal_table_unpack_row_plan(table, row, sim_burst_basic, new))
 		goto error;
 
-	/* do this after unpack_row() to let it confirm the column is
-	 * present and has the correct type.  shouldn't need to check for
-	 * errors here */
-	ligolw_cell_string_copy(ligolw_row_get_cell(row, "waveform", NULL), new->waveform, LIGOMETA_WAVEFORM_MAX - 1);
-
 	/* unpack additional columns depending on the waveform */
 	if(!strcmp(new->waveform, "StringCusp"))
 		result_code = ligolw_table_unpack_row(table, *row, sim_burst_StringCusp);
@@ -118,13 +112,11 @@ int ligolw_sim_burst_row_callback(struct ligolw_table *table, struct ligolw_tabl
 	*head = new;
 
 	/* success */
-	ligolw_table_free_row_data(table, row);
-	free(row);
+	ligolw_table_free_row(table, row);
 	return 0;
 
 error:
 	XLALDestroySimBurst(new);
-	ligolw_table_free_row_data(table, row);
-	free(row);
+	ligolw_table_free_row(table, row);
 	return -1;
 }
@@ -30,7 +30,7 @@ int ligolw_sim_inspiral_row_callback(struct ligolw_table *table, struct ligolw_t
 	SimInspiralTable *new = LALCalloc(1, sizeof(*new));	/* ugh, lal */
 	struct ligolw_unpacking_spec spec[] = {
 		{"process:process_id", &new->process_id, NULL, ligolw_cell_type_int_8s, LIGOLW_COLUMN_FLAGS_REQUIRED},
-		{"waveform", NULL, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED},
+		{"waveform", new->waveform, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED, LIGOMETA_WAVEFORM_MAX},
 		{"geocent_end_time", &new->geocent_end_time.gpsSeconds, NULL, ligolw_cell_type_int_4s, LIGOLW_COLUMN_FLAGS_REQUIRED},
 		{"geocent_end_time_ns", &new->geocent_end_time.gpsNanoSeconds, NULL, ligolw_cell_type_int_4s, LIGOLW_COLUMN_FLAGS_REQUIRED},
 
@@ -49,7 +49,7 @@ int ligolw_sim_inspiral_row_callback(struct ligolw_table *table, struct ligolw_t
 		{"v_end_time", &new->v_end_time.gpsSeconds, NULL, ligolw_cell_type_int_4s, LIGOLW_COLUMN_FLAGS_NONE},
 		{"v_end_time", &new->v_end_time.gpsNanoSeconds, NULL, ligolw_cell_type_int_4s, LIGOLW_COLUMN_FLAGS_NONE},
 
-		{"source", NULL, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED},
+		{"source", new->source, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED, LIGOMETA_SOURCE_MAX},
 		{"mass1", &new->mass1, NULL, ligolw_cell_type_real_4, LIGOLW_COLUMN_FLAGS_REQUIRED},
 		{"mass2", &new->mass2, NULL, ligolw_cell_type_real_4, LIGOLW_COLUMN_FLAGS_REQUIRED},
 		{"mchirp", &new->mchirp, NULL, ligolw_cell_type_real_4, LIGOLW_COLUMN_FLAGS_REQUIRED},
@@ -90,9 +90,9 @@ int ligolw_sim_inspiral_row_callback(struct ligolw_table *table, struct ligolw_t
 
 		{"numrel_mode_min", &new->numrel_mode_min, NULL, ligolw_cell_type_int_4s, LIGOLW_COLUMN_FLAGS_REQUIRED},
 		{"numrel_mode_max", &new->numrel_mode_max, NULL, ligolw_cell_type_int_4s, LIGOLW_COLUMN_FLAGS_REQUIRED},
-		{"numrel_data", NULL, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED},
+		{"numrel_data", new->numrel_data, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED, LIGOMETA_STRING_MAX},
 		{"amp_order", &new->amp_order, NULL, ligolw_cell_type_int_4s, LIGOLW_COLUMN_FLAGS_REQUIRED},
-		{"taper", NULL, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED},
+		{"taper", new->taper, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED, LIGOMETA_INSPIRALTAPER_MAX},
 		{"bandpass", &new->bandpass, NULL, ligolw_cell_type_int_4s, LIGOLW_COLUMN_FLAGS_REQUIRED},
 		{"simulation_id", &new->simulation_id, NULL, ligolw_cell_type_int_8s, LIGOLW_COLUMN_FLAGS_REQUIRED},
 		{NULL, NULL, NULL, -1, 0}
@@ -104,31 +104,20 @@ int ligolw_sim_inspiral_row_callback(struct ligolw_table *table, struct ligolw_t
 		goto error;
 	}
 
-	/* unpack.  have to do the strings manually because they get copied
-	 * by value rather than reference. */
-	if(ligolw_table_unpack_row(table, *row, spec))
+	/* unpack.  strings are copied into the structure's arrays */
+	if(ligolw_lal_table_unpack_row_plan(table, row, spec, new))
 		goto error;
 
-	/* do this after unpack_row() to let it confirm the columns are
-	 * present and have the correct type.  shouldn't need to check for
-	 * errors here */
-	ligolw_cell_string_copy(ligolw_row_get_cell(row, "waveform", NULL), new->waveform, LIGOMETA_WAVEFORM_MAX - 1);
-	ligolw_cell_string_copy(ligolw_row_get_cell(row, "source", NULL), new->source, LIGOMETA_SOURCE_MAX - 1);
-	ligolw_cell_string_copy(ligolw_row_get_cell(row, "numrel_data", NULL), new->numrel_data, LIGOMETA_STRING_MAX - 1);
-	ligolw_cell_string_copy(ligolw_row_get_cell(row, "taper", NULL), new->taper, LIGOMETA_INSPIRALTAPER_MAX - 1);
-
 	/* add new row object to head of linked list */
 	new->next = *head;
 	*head = new;
 
 	/* success */
-	ligolw_table_free_row_data(table, row);
-	free(row);
+	ligolw_table_free_row(table, row);
 	return 0;
 
 error:
 	free(new);
-	ligolw_table_free_row_data(table, row);
-	free(row);
+	ligolw_table_free_row(table, row);
 	return -1;
 }
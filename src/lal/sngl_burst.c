@@ -31,9 +31,9 @@ int ligolw_sngl_burst_row_callback(struct ligolw_table *table, struct ligolw_tab
 	struct ligolw_unpacking_spec spec[] = {
 		{"process:process_id", &new->process_id, NULL, ligolw_cell_type_int_8s, LIGOLW_COLUMN_FLAGS_REQUIRED},
 		{"event_id", &new->event_id, NULL, ligolw_cell_type_int_8s, LIGOLW_COLUMN_FLAGS_REQUIRED},
-		{"ifo", NULL, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED},
-		{"search", NULL, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED},
-		{"channel", NULL, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED},
+		{"ifo", new->ifo, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED, LIGOMETA_IFO_MAX},
+		{"search", new->search, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED, LIGOMETA_SEARCH_MAX},
+		{"channel", new->channel, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED, LIGOMETA_CHANNEL_MAX},
 		{"start_time", &new->start_time.gpsSeconds, NULL, ligolw_cell_type_int_4s, LIGOLW_COLUMN_FLAGS_REQUIRED},
 		{"start_time_ns", &new->start_time.gpsNanoSeconds, NULL, ligolw_cell_type_int_4s, LIGOLW_COLUMN_FLAGS_REQUIRED},
 		{"peak_time", &new->peak_time.gpsSeconds, NULL, ligolw_cell_type_int_4s, LIGOLW_COLUMN_FLAGS_REQUIRED},
@@ -56,30 +56,20 @@ int ligolw_sngl_burst_row_callback(struct ligolw_table *table, struct ligolw_tab
 		goto error;
 	}
 
-	/* unpack.  have to do the strings manually because they get copied
-	 * by value rather than reference. */
-	if(ligolw_table_unpack_row(table, *row, spec))
+	/* unpack.  strings are copied into the structure's arrays */
+	if(ligolw_lal_table_unpack_row_plan(table, row, spec, new))
 		goto error;
 
-	/* do this after unpack_row() to let it confirm the columns are
-	 * present and have the correct type.  shouldn't need to check for
-	 * errors here */
-	ligolw_cell_string_copy(ligolw_row_get_cell(row, "ifo", NULL), new->ifo, LIGOMETA_IFO_MAX - 1);
-	ligolw_cell_string_copy(ligolw_row_get_cell(row, "search", NULL), new->search, LIGOMETA_SEARCH_MAX - 1);
-	ligolw_cell_string_copy(ligolw_row_get_cell(row, "channel", NULL), new->channel, LIGOMETA_CHANNEL_MAX - 1);
-
 	/* add new row object to head of linked list */
 	new->next = *head;
 	*head = new;
 
 	/* success */
-	ligolw_table_free_row_data(table, row);
-	free(row);
+	ligolw_table_free_row(table, row);
 	return 0;
 
 error:
 	free(new);
-	ligolw_table_free_row_data(table, row);
-	free(row);
+	ligolw_table_free_row(table, row);
 	return -1;
 }
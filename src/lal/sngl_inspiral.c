@@ -46,9 +46,9 @@ int ligolw_sngl_inspiral_row_callback(struct ligolw_table *table, struct ligolw_
 		{"f_final", &new->f_final, NULL, ligolw_cell_type_real_4, LIGOLW_COLUMN_FLAGS_REQUIRED},
 		{"template_duration", &new->template_duration, NULL, ligolw_cell_type_real_8, LIGOLW_COLUMN_FLAGS_REQUIRED},
 		{"ttotal", &new->ttotal, NULL, ligolw_cell_type_real_4, LIGOLW_COLUMN_FLAGS_REQUIRED},
-		{"search", NULL, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED},
-		{"ifo", NULL, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED},
-		{"channel", NULL, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED},
+		{"search", new->search, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED, LIGOMETA_SEARCH_MAX},
+		{"ifo", new->ifo, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED, LIGOMETA_IFO_MAX},
+		{"channel", new->channel, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED, LIGOMETA_CHANNEL_MAX},
 		{"sigmasq", &new->sigmasq, NULL, ligolw_cell_type_real_8, LIGOLW_COLUMN_FLAGS_REQUIRED},
 		{"snr", &new->snr, NULL, ligolw_cell_type_real_4, LIGOLW_COLUMN_FLAGS_REQUIRED},
 		{"coa_phase", &new->coa_phase, NULL, ligolw_cell_type_real_4, LIGOLW_COLUMN_FLAGS_REQUIRED},
@@ -103,30 +103,20 @@ int ligolw_sngl_inspiral_row_callback(struct ligolw_table *table, struct ligolw_
 		goto error;
 	}
 
-	/* unpack.  have to do the strings manually because they get copied
-	 * by value rather than reference.  */
-	if(ligolw_table_unpack_row(table, *row, spec))
+	/* unpack.  strings are copied into the structure's arrays */
+	if(ligolw_lal_table_unpack_row_plan(table, row, spec, new))
 		goto error;
 
-	/* do this after unpack_row() to let it confirm the columns are
-	 * present and have the correct type.  shouldn't need to check for
-	 * errors here */
-	ligolw_cell_string_copy(ligolw_row_get_cell(row, "search", NULL), new->search, LIGOMETA_SEARCH_MAX - 1);
-	ligolw_cell_string_copy(ligolw_row_get_cell(row, "ifo", NULL), new->ifo, LIGOMETA_IFO_MAX - 1);
-	ligolw_cell_string_copy(ligolw_row_get_cell(row, "channel", NULL), new->channel, LIGOMETA_CHANNEL_MAX - 1);
-
 	/* add new row object to head of linked list */
 	new->next = *head;
 	*head = new;
 
 	/* success */
-	ligolw_table_free_row_data(table, row);
-	free(row);
+	ligolw_table_free_row(table, row);
 	return 0;
 
 error:
 	free(new);
-	ligolw_table_free_row_data(table, row);
-	free(row);
+	ligolw_table_free_row(table, row);
 	return -1;
 }
@@ -31,7 +31,7 @@ int ligolw_time_slide_row_callback(struct ligolw_table *table, struct ligolw_tab
 	struct ligolw_unpacking_spec spec[] = {
 		{"process:process_id", &new->process_id, NULL, ligolw_cell_type_int_8s, LIGOLW_COLUMN_FLAGS_REQUIRED},
 		{"time_slide_id", &new->time_slide_id, NULL, ligolw_cell_type_int_8s, LIGOLW_COLUMN_FLAGS_REQUIRED},
-		{"instrument", NULL, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED},
+		{"instrument", new->instrument, NULL, ligolw_cell_type_lstring, LIGOLW_COLUMN_FLAGS_REQUIRED, LIGOMETA_STRING_MAX},
 		{"offset", &new->offset, NULL, ligolw_cell_type_real_8, LIGOLW_COLUMN_FLAGS_REQUIRED},
 		{NULL, NULL, NULL, -1, 0}
 	};
@@ -42,28 +42,20 @@ int ligolw_time_slide_row_callback(struct ligolw_table *table, struct ligolw_tab
 		goto error;
 	}
 
-	/* unpack.  have to do the strings manually because they get copied
-	 * by value rather than reference. */
-	if(ligolw_table_unpack_row(table, *row, spec))
+	/* unpack.  strings are copied into the structure's arrays */
+	if(ligolw_lal_table_unpack_row_plan(table, row, spec, new))
 		goto error;
 
-	/* do this after unpack_row() to let it confirm the column is
-	 * present and has the correct type.  shouldn't need to check for
-	 * errors here */
-	ligolw_cell_string_copy(ligolw_row_get_cell(row, "instrument", NULL), new->instrument, LIGOMETA_STRING_MAX - 1);
-
 	/* add new row object to head of linked list */
 	new->next = *head;
 	*head = new;
 
 	/* success */
-	ligolw_table_free_row_data(table, row);
-	free(row);
+	ligolw_table_free_row(table, row);
 	return 0;
 
 error:
 	XLALDestroyTimeSlide(new);
-	ligolw_table_free_row_data(table, row);
-	free(row);
+	ligolw_table_free_row(table, row);
 	return -1;
 }
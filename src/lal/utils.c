@@ -23,6 +23,24 @@
 #include <ezligolw/lal.h>
 
 
+/*
+ * Report a ligolw_table_unpack_row() result code via the XLALPrintError()
+ * error reporting mechanism.
+ */
+
+
+static void ligolw_lal_report_unpack_error(const struct ligolw_unpacking_spec *spec, int result_code)
+{
+	if(result_code > 0) {
+		/* missing required column */
+		XLALPrintError("failure parsing row: missing column \"%s\"\n", spec[result_code - 1].name);
+	} else if(result_code < 0) {
+		/* column type mismatch */
+		XLALPrintError("failure parsing row: incorrect type for column \"%s\"\n", spec[-result_code - 1].name);
+	}
+}
+
+
 /*
  * Wrapper around ligolw_table_unpack_row() that reports errors via the
  * XLALPrintError() error reporting mechanism.  Reduces line count in LAL
@@ -35,16 +53,38 @@ int ligolw_lal_table_unpack_row(struct ligolw_table *table, struct ligolw_table_
 	int result_code;
 
 	result_code = ligolw_table_unpack_row(table, row, spec);
+	ligolw_lal_report_unpack_error(spec, result_code);
 
-	if(result_code > 0) {
-		/* missing required column */
-		XLALPrintError("failure parsing row: missing column \"%s\"\n", spec[result_code - 1].name);
-	} else if(result_code < 0) {
-		/* column type mismatch */
-		XLALPrintError("failure parsing row: incorrect type for column \"%s\"\n", spec[-result_code - 1].name);
+	return result_code;
+}
+
+
+/*
+ * Same as ligolw_lal_table_unpack_row(), but the spec is compiled into
+ * table->plan on the first row and the plan is used for every row after
+ * that, so the columns are looked up once per table instead of once per
+ * row.  base is the address of the row structure into which the spec's
+ * destinations point.  The spec must be the same for every row of the
+ * table, except for base.
+ */
+
+
+int ligolw_lal_table_unpack_row_plan(struct ligolw_table *table, struct ligolw_table_row *row, struct ligolw_unpacking_spec *spec, void *base)
+{
+	if(!table->plan) {
+		int result_code;
+		table->plan = ligolw_unpacking_plan_new(table, spec, base, &result_code);
+		if(!table->plan) {
+			if(!result_code) {
+				XLALPrintError("memory allocation failure\n");
+				return -1;
+			}
+			ligolw_lal_report_unpack_error(spec, result_code);
+			return result_code;
+		}
 	}
 
-	return result_code;
+	return ligolw_unpacking_plan_apply(table->plan, row, base);
 }
 
 
@@ -63,6 +103,22 @@ int ligolw_lal_table_unpack_row(struct ligolw_table *table, struct ligolw_table_
  */
 
 
+static int (*ligolw_lal_row_callback(const char *table_name))(struct ligolw_table *, struct ligolw_table_row *, void *)
+{
+	if(!strcmp(table_name, "sim_burst"))
+		return ligolw_sim_burst_row_callback;
+	if(!strcmp(table_name, "sim_inspiral"))
+		return ligolw_sim_inspiral_row_callback;
+	if(!strcmp(table_name, "sngl_burst"))
+		return ligolw_sngl_burst_row_callback;
+	if(!strcmp(table_name, "sngl_inspiral"))
+		return ligolw_sngl_inspiral_row_callback;
+	if(!strcmp(table_name, "time_slide"))
+		return ligolw_time_slide_row_callback;
+	return NULL;
+}
+
+
 void *ligolw_lal_table_get(
 	ezxml_t elem,
 	const char *table_name,
@@ -70,22 +126,17 @@ void *ligolw_lal_table_get(
 )
 {
 	struct ligolw_table *table;
+	struct ligolw_table_options options = {0};
 	/* empty linked list */
 	void *head = NULL;
 
-	/* select row_callback() if neded */
-	if(row_callback) {
-	} else if(!strcmp(table_name, "sim_burst"))
-		row_callback = ligolw_sim_burst_row_callback;
-	else if(!strcmp(table_name, "sim_inspiral"))
-		row_callback = ligolw_sim_inspiral_row_callback;
-	else if(!strcmp(table_name, "sngl_burst"))
-		row_callback = ligolw_sngl_burst_row_callback;
-	else if(!strcmp(table_name, "sngl_inspiral"))
-		row_callback = ligolw_sngl_inspiral_row_callback;
-	else if(!strcmp(table_name, "time_slide"))
-		row_callback = ligolw_time_slide_row_callback;
-	else {
+	/* select row_callback() if neded.  ours copy everything out of
+	 * the rows, so the rows can be re-used */
+	if(!row_callback) {
+		row_callback = ligolw_lal_row_callback(table_name);
+		options.flags = LIGOLW_TABLE_REUSE_ROW;
+	}
+	if(!row_callback) {
 		XLALPrintError("table \"%s\" not recognized\n", table_name);
 		XLAL_ERROR_NULL(XLAL_EINVAL);
 	}
@@ -98,7 +149,7 @@ void *ligolw_lal_table_get(
 	}
 
 	/* convert the rows to a LAL-style linked list */
-	table = ligolw_table_parse(elem, row_callback, &head);
+	table = ligolw_table_parse_opts(elem, &options, row_callback, &head);
 	if(!table) {
 		XLALPrintError("failure parsing \"%s\" table\n", table_name);
 		XLAL_ERROR_NULL(XLAL_EDATA);
@@ -110,3 +161,48 @@ void *ligolw_lal_table_get(
 	/* success */
 	return head;
 }
+
+
+/*
+ * Equivalent to ligolw_lal_table_get() but reads the table directly from
+ * a (possibly gzip-compressed) file using ligolw_table_parse_gzfile(),
+ * without loading the document into memory.  Use this for large trigger
+ * files.
+ *
+ * Returns the address of the head of a linked list of rows, or NULL on
+ * error.  As with ligolw_lal_table_get(), an empty table is also reported
+ * as NULL, and xlalErrno distinguishes the two cases.
+ */
+
+
+void *ligolw_lal_table_get_from_file(
+	const char *filename,
+	const char *table_name,
+	int row_callback(struct ligolw_table *, struct ligolw_table_row *, void *)
+)
+{
+	struct ligolw_table *table;
+	/* empty linked list */
+	void *head = NULL;
+
+	/* select row_callback() if neded */
+	if(!row_callback)
+		row_callback = ligolw_lal_row_callback(table_name);
+	if(!row_callback) {
+		XLALPrintError("table \"%s\" not recognized\n", table_name);
+		XLAL_ERROR_NULL(XLAL_EINVAL);
+	}
+
+	/* convert the rows to a LAL-style linked list */
+	table = ligolw_table_parse_gzfile(filename, table_name, row_callback, &head);
+	if(!table) {
+		XLALPrintError("failure reading \"%s\" table from \"%s\"\n", table_name, filename);
+		XLAL_ERROR_NULL(XLAL_EIO);
+	}
+
+	/* clean up */
+	ligolw_table_free(table);
+
+	/* success */
+	return head;
+}
@@ -95,7 +95,7 @@ static const char *ligolw_strip_dim_name(const char *Name)
 struct ligolw_array *ligolw_array_parse(ezxml_t elem)
 {
 	struct ligolw_array *array;
-	char *txt;
+	const char *txt, *end;
 	ezxml_t dim;
 	ezxml_t stream;
 	char *data;
@@ -148,6 +148,12 @@ struct ligolw_array *ligolw_array_parse(ezxml_t elem)
 		return array;
 	}
 
+	/* a lazily parsed document decodes the Stream on first use */
+	if(!ezxml_txt_decode(stream)) {
+		ligolw_array_free(array);
+		return NULL;
+	}
+
 	stride = ligolw_type_enum_to_size(array->type);
 	array->data = malloc(n * stride);
 	if(!array->data) {
@@ -163,33 +169,45 @@ struct ligolw_array *ligolw_array_parse(ezxml_t elem)
 	}
 
 	switch(encoding = ligolw_stream_check_encoding(stream)) {
-	case ligolw_stream_enc_text:
-		for(data = array->data, txt = stream->txt; txt && *txt; data += stride) {
+	case ligolw_stream_enc_text: {
+		struct ligolw_stream_index *index;
+		txt = stream->txt;
+		end = txt + ezxml_txt_len(stream);
+		index = ligolw_stream_index_new(txt, end, array->delimiter);
+		if(!index) {
+			ligolw_array_free(array);
+			return NULL;
+		}
+		for(data = array->data; txt < end; data += stride) {
 			union ligolw_cell cell;
-			char *start, *end;
+			const char *start, *stop;
+			int escapes = ligolw_stream_index_next_token(index, &txt, &start, &stop);
 
-			ligolw_stream_next_token(&txt, &start, &end, array->delimiter);
+			/* white space following a trailing delimiter is
+			 * not a token */
+			if(!escapes && start == stop && txt == end)
+				break;
 
 			/* we have confirmed above that array->type is a
-			 * numeric type, so we don't need to bother
-			 * null-terminating the token before calling
-			 * _cell_from_txt because parsing will
-			 * automatically stop at the end of the number.  we
-			 * also know we will not be given ownership of a
-			 * string or blob pointer that requires free(). */
-			if(!ligolw_cell_from_txt(&cell, array->type, start) || ligolw_cell_to_c(&cell, array->type, data) < 0) {
+			 * numeric type, so we know we will not be given
+			 * ownership of a string or blob pointer that
+			 * requires free(). */
+			if(escapes < 0 || data >= (char *) array->data + n * stride || !ligolw_stream_token_to_cell(&cell, array->type, start, stop, escapes) || ligolw_cell_to_c(&cell, array->type, data) < 0) {
+				ligolw_stream_index_free(index);
 				ligolw_array_free(array);
 				return NULL;
 			}
 		}
+		ligolw_stream_index_free(index);
 		break;
+	}
 
 	case ligolw_stream_enc_b64be:
 	case ligolw_stream_enc_b64le: {
 		base64_decodestate b64state;
 		base64_init_decodestate(&b64state);
 		/* decode the base64 data */
-		if(base64_decode_block(stream->txt, strlen(stream->txt), array->data, &b64state) != n * stride) {
+		if(base64_decode_block(stream->txt, ezxml_txt_len(stream), array->data, &b64state) != n * stride) {
 			/* decoded size did not match array size.  we might
 			 * have corrupted memory, but other than try to
 			 * clean up and return an error code there's not
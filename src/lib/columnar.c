@@ -0,0 +1,543 @@
+/*
+ * Copyright (C) 2026  agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+/*
+ * Columnar (struct-of-arrays) Table representation.  Instead of an array
+ * of rows, each holding an array of union ligolw_cell objects, each column
+ * is stored as one contiguous array of its C type, so that, for example, a
+ * real_4 column is an array of floats that can be scanned with vector
+ * instructions or handed to other code without being gathered row by row
+ * first.
+ */
+
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <./stream.h>
+#include <./table.h>
+#include <ezligolw/ezligolw.h>
+
+
+/* number of rows for which space is first allocated */
+#define LIGOLW_COLUMNAR_MIN_ROWS 1024
+
+
+/*
+ * Is the column's data variable-length?  Such columns are stored as the
+ * concatenation of their values, with an offset and length for each row.
+ */
+
+
+static bool columnar_is_varlen(enum ligolw_cell_type type)
+{
+	switch(type) {
+	case ligolw_cell_type_char_s:
+	case ligolw_cell_type_char_v:
+	case ligolw_cell_type_ilwdchar:
+	case ligolw_cell_type_ilwdchar_u:
+	case ligolw_cell_type_lstring:
+	case ligolw_cell_type_blob:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+
+/*
+ * Hash table of the distinct values of a dictionary encoded column, by
+ * which the code of a row's value is found.
+ */
+
+
+struct columnar_dictionary {
+	/* the codes of the values, with -1 marking empty slots.  there are
+	 * mask + 1 slots, and they are kept at most half full.  NULL if
+	 * the column is not dictionary encoded */
+	int *slots;
+	unsigned mask;
+	/* the number of values the offsets and lengths arrays have room
+	 * for */
+	int capacity;
+};
+
+
+/*
+ * Grow the per-row arrays of every selected column to hold n rows.
+ * Returns < 0 on failure.
+ */
+
+
+static int columnar_grow(struct ligolw_columnar_table *table, const bool *selected, const struct columnar_dictionary *dictionaries, int n)
+{
+	int c;
+
+	for(c = 0; c < table->n_columns; c++) {
+		struct ligolw_columnar_column *column = &table->columns[c];
+		if(selected && !selected[c])
+			continue;
+		if(dictionaries[c].slots) {
+			/* the values are grown as they are found */
+			int *codes = realloc(column->codes, n * sizeof(*codes));
+			if(!codes)
+				return -1;
+			column->codes = codes;
+		} else if(columnar_is_varlen(column->type)) {
+			size_t *offsets = realloc(column->offsets, n * sizeof(*offsets));
+			if(!offsets)
+				return -1;
+			column->offsets = offsets;
+			offsets = realloc(column->lengths, n * sizeof(*offsets));
+			if(!offsets)
+				return -1;
+			column->lengths = offsets;
+		} else {
+			void *data = realloc(column->data, n * ligolw_type_enum_to_size(column->type));
+			if(!data)
+				return -1;
+			column->data = data;
+		}
+	}
+
+	return 0;
+}
+
+
+/*
+ * Append the value of a string or blob token to a variable-length
+ * column, removing escape sequences, as its value number i.  size points
+ * to the allocated size of the column's data, which is grown as needed.
+ * Strings are stored with their terminating null characters, which are not
+ * included in their lengths.  Returns < 0 on failure.
+ */
+
+
+static int columnar_append(struct ligolw_columnar_column *column, size_t *size, int i, const char *start, const char *stop, int escapes)
+{
+	size_t offset = i ? column->offsets[i - 1] + column->lengths[i - 1] + 1 : 0;
+	union ligolw_cell cell;
+	size_t len;
+	char *dst;
+
+	if(column->type == ligolw_cell_type_blob) {
+		if(!ligolw_stream_token_to_cell(&cell, column->type, start, stop, escapes))
+			return -1;
+		start = cell.as_blob.data;
+		len = cell.as_blob.len;
+	} else
+		len = stop - start - escapes;
+
+	if(offset + len + 1 > *size) {
+		size_t n = *size ? *size : 4096;
+		while(n < offset + len + 1)
+			n *= 2;
+		dst = realloc(column->data, n);
+		if(!dst) {
+			if(column->type == ligolw_cell_type_blob)
+				free(cell.as_blob.data);
+			return -1;
+		}
+		column->data = dst;
+		*size = n;
+	}
+
+	dst = (char *) column->data + offset;
+	if(column->type == ligolw_cell_type_blob) {
+		memcpy(dst, start, len);
+		free(cell.as_blob.data);
+	} else if(!escapes)
+		memcpy(dst, start, len);
+	else
+		/* the tokenizer has confirmed that every '\\' starts a
+		 * valid escape sequence */
+		for(; start < stop; *dst++ = *start++)
+			if(*start == '\\')
+				start++;
+	((char *) column->data)[offset + len] = '\0';
+
+	column->offsets[i] = offset;
+	column->lengths[i] = len;
+
+	return 0;
+}
+
+
+/*
+ * FNV-1a hash of a value of a dictionary encoded column.
+ */
+
+
+static unsigned columnar_hash(const char *value, size_t len)
+{
+	unsigned hash = 2166136261u;
+
+	while(len--)
+		hash = (hash ^ (unsigned char) *value++) * 16777619u;
+
+	return hash;
+}
+
+
+/*
+ * Find the slot of a value in a dictionary's hash table:  the slot holding
+ * the code of the column's equal value, or the empty slot where its code
+ * belongs if the column has no equal value.
+ */
+
+
+static unsigned columnar_dictionary_slot(const struct ligolw_columnar_column *column, const struct columnar_dictionary *dictionary, const char *value, size_t len)
+{
+	unsigned i;
+	int code;
+
+	for(i = columnar_hash(value, len) & dictionary->mask; (code = dictionary->slots[i]) >= 0; i = (i + 1) & dictionary->mask)
+		if(column->lengths[code] == len && !memcmp((char *) column->data + column->offsets[code], value, len))
+			break;
+
+	return i;
+}
+
+
+/*
+ * Store the code of a string token's value as the row's in a dictionary
+ * encoded column, adding the value to the column's values if it is new.
+ * The value is decoded into the column's data as if it were new, and if
+ * it turns out not to be the next value decoded overwrites it.  size is as
+ * for columnar_append().  Returns < 0 on failure.
+ */
+
+
+static int columnar_encode(struct ligolw_columnar_column *column, struct columnar_dictionary *dictionary, size_t *size, int row, const char *start, const char *stop, int escapes)
+{
+	unsigned i;
+
+	if(column->n_values == dictionary->capacity) {
+		int n = dictionary->capacity ? 2 * dictionary->capacity : 16;
+		size_t *offsets = realloc(column->offsets, n * sizeof(*offsets));
+		if(!offsets)
+			return -1;
+		column->offsets = offsets;
+		offsets = realloc(column->lengths, n * sizeof(*offsets));
+		if(!offsets)
+			return -1;
+		column->lengths = offsets;
+		dictionary->capacity = n;
+	}
+
+	if(2 * (column->n_values + 1) > (int) dictionary->mask + 1) {
+		/* re-build the hash table with twice as many slots */
+		unsigned mask = 2 * dictionary->mask + 1;
+		int *slots = malloc((mask + 1) * sizeof(*slots));
+		int code;
+		if(!slots)
+			return -1;
+		free(dictionary->slots);
+		dictionary->slots = slots;
+		dictionary->mask = mask;
+		memset(slots, 0xff, (mask + 1) * sizeof(*slots));
+		for(code = 0; code < column->n_values; code++)
+			slots[columnar_dictionary_slot(column, dictionary, (char *) column->data + column->offsets[code], column->lengths[code])] = code;
+	}
+
+	if(columnar_append(column, size, column->n_values, start, stop, escapes) < 0)
+		return -1;
+	i = columnar_dictionary_slot(column, dictionary, (char *) column->data + column->offsets[column->n_values], column->lengths[column->n_values]);
+	if(dictionary->slots[i] < 0)
+		/* new value, keep it */
+		dictionary->slots[i] = column->n_values++;
+	column->codes[row] = dictionary->slots[i];
+
+	return 0;
+}
+
+
+/*
+ * Free the dictionaries' hash tables.
+ */
+
+
+static void columnar_dictionaries_free(const struct ligolw_columnar_table *table, struct columnar_dictionary *dictionaries)
+{
+	int c;
+
+	for(c = 0; dictionaries && c < table->n_columns; c++)
+		free(dictionaries[c].slots);
+	free(dictionaries);
+}
+
+
+/*
+ * Parse an ezxml_t Table element into a struct ligolw_columnar_table.  For
+ * numeric columns, the column's data is an array of n_rows values of the C
+ * type ligolw_cell_to_c() would store (int16_t, uint32_t, float, double
+ * complex, etc.).  For string and blob columns, data is the concatenation
+ * of the column's values, each followed by a null character, and offsets
+ * and lengths give the position in data and the length of each row's
+ * value, so the string in row i of a string column is (char *) data +
+ * offsets[i].  offsets and lengths are NULL for numeric columns.
+ *
+ * options may be NULL.  If options->columns is not NULL only the columns
+ * it names are converted, the data, offsets and lengths of the others are
+ * left NULL.  If options->filter is not NULL only the rows for which it is
+ * true are stored, see ligolw_table_parse_opts().
+ *
+ * If options->dictionary is not NULL the string columns it names are
+ * dictionary encoded:  each distinct value is stored once, in the order in
+ * which they are first found, with data, offsets and lengths describing
+ * the n_values values instead of the rows, and codes is an array of
+ * n_rows ints giving the index of each row's value among them, so the
+ * string in row i is (char *) data + offsets[codes[i]].  This suits
+ * columns such as instrument names that hold a few values repeated many
+ * times:  they take a fraction of the memory, and rows can be grouped by
+ * value by comparing codes.  Names that are not the names of string
+ * columns are ignored.
+ *
+ * Returns the address of a new struct ligolw_columnar_table, which the
+ * calling code must free with ligolw_columnar_table_free(), or NULL on
+ * failure, including if a column's type is not recognized.
+ */
+
+
+struct ligolw_columnar_table *ligolw_columnar_table_parse(ezxml_t elem, const struct ligolw_table_options *options)
+{
+	struct ligolw_columnar_table *table;
+	struct ligolw_table *header;
+	struct ligolw_table_filter_prog *prog = NULL;
+	struct ligolw_stream_token *tokens = NULL;
+	struct ligolw_stream_index *index = NULL;
+	union ligolw_cell *cells = NULL;
+	const char *txt, *end;
+	size_t *sizes = NULL;
+	struct columnar_dictionary *dictionaries = NULL;
+	bool *selected = NULL;
+	bool failed;
+	ezxml_t stream;
+	int capacity = 0;
+	int c;
+
+	/* this simplifies error checking in calling code */
+	if(!elem)
+		return NULL;
+
+	/* the column names and types, and the Stream's delimiter, are
+	 * collected just as for ligolw_table_parse() */
+	header = ligolw_table_new(elem);
+	if(!header)
+		return NULL;
+
+	table = malloc(sizeof(*table));
+	if(!table) {
+		ligolw_table_free(header);
+		return NULL;
+	}
+	table->name = header->name;
+	table->n_columns = header->n_columns;
+	table->n_rows = 0;
+	table->columns = calloc(header->n_columns, sizeof(*table->columns));
+	if(!table->columns && header->n_columns) {
+		ligolw_table_free(header);
+		free(table);
+		return NULL;
+	}
+
+	/* the table can now be free()ed with ligolw_columnar_table_free() */
+
+	for(c = 0; c < table->n_columns; c++) {
+		table->columns[c].name = header->columns[c].name;
+		table->columns[c].type = header->columns[c].type;
+		if(!columnar_is_varlen(table->columns[c].type) && ligolw_type_enum_to_size(table->columns[c].type) == (size_t) -1) {
+			/* unrecognized type */
+			goto error;
+		}
+	}
+
+	stream = ezxml_child(elem, "Stream");
+	if(!stream) {
+		/* DTD allows Table to have 0 Stream children */
+		ligolw_table_free(header);
+		return table;
+	}
+
+	/* a lazily parsed document decodes the Stream on first use */
+	txt = ezxml_txt_decode(stream);
+	if(txt) {
+		end = txt + ezxml_txt_len(stream);
+		index = ligolw_stream_index_new(txt, end, header->delimiter);
+	}
+	/* allocated sizes of the variable-length columns' data */
+	sizes = calloc(table->n_columns + 1, sizeof(*sizes));
+	tokens = malloc((table->n_columns + 1) * sizeof(*tokens));
+	/* the decoded values of the filter's columns */
+	cells = calloc(table->n_columns + 1, sizeof(*cells));
+	dictionaries = calloc(table->n_columns + 1, sizeof(*dictionaries));
+	selected = ligolw_table_selected_columns(header, options, &failed);
+	if(!txt || !index || !sizes || !tokens || !cells || !dictionaries || failed)
+		goto error;
+	if(options && options->dictionary) {
+		const char *const *name;
+		for(name = options->dictionary; *name; name++) {
+			enum ligolw_cell_type type;
+			c = ligolw_table_get_column(header, *name, &type);
+			if(c < 0 || dictionaries[c].slots || type == ligolw_cell_type_blob || !columnar_is_varlen(type) || (selected && !selected[c]))
+				continue;
+			dictionaries[c].mask = 15;
+			dictionaries[c].slots = malloc((dictionaries[c].mask + 1) * sizeof(*dictionaries[c].slots));
+			if(!dictionaries[c].slots)
+				goto error;
+			memset(dictionaries[c].slots, 0xff, (dictionaries[c].mask + 1) * sizeof(*dictionaries[c].slots));
+		}
+	}
+	if(options && options->filter) {
+		prog = ligolw_table_filter_compile(header, options->filter);
+		if(!prog)
+			goto error;
+	}
+
+	while(txt < end) {
+		if(ligolw_table_next_row(header, index, &txt, tokens) < 0) {
+			/* malformed Stream */
+			goto error;
+		}
+
+		if(prog) {
+			for(c = 0; c < table->n_columns; c++)
+				if(prog->columns[c] && !ligolw_stream_token_to_cell(&cells[c], table->columns[c].type, tokens[c].start, tokens[c].stop, tokens[c].escapes))
+					goto error;
+			if(!ligolw_table_filter_eval(prog, cells)) {
+				/* rejected */
+				ligolw_table_free_cells(header, cells, prog->columns);
+				continue;
+			}
+		}
+
+		if(table->n_rows == capacity) {
+			capacity = capacity ? 2 * capacity : LIGOLW_COLUMNAR_MIN_ROWS;
+			if(columnar_grow(table, selected, dictionaries, capacity) < 0)
+				goto error;
+		}
+
+		for(c = 0; c < table->n_columns; c++) {
+			struct ligolw_columnar_column *column = &table->columns[c];
+
+			if(selected && !selected[c])
+				/* column not wanted */
+				continue;
+
+			if(dictionaries[c].slots) {
+				if(columnar_encode(column, &dictionaries[c], &sizes[c], table->n_rows, tokens[c].start, tokens[c].stop, tokens[c].escapes) < 0)
+					goto error;
+			} else if(columnar_is_varlen(column->type)) {
+				if(columnar_append(column, &sizes[c], table->n_rows, tokens[c].start, tokens[c].stop, tokens[c].escapes) < 0)
+					goto error;
+			} else {
+				/* the filter's columns are already converted */
+				if(!(prog && prog->columns[c]) && !ligolw_stream_token_to_cell(&cells[c], column->type, tokens[c].start, tokens[c].stop, tokens[c].escapes))
+					goto error;
+				ligolw_cell_to_c(&cells[c], column->type, (char *) column->data + table->n_rows * ligolw_type_enum_to_size(column->type));
+			}
+		}
+		if(prog)
+			ligolw_table_free_cells(header, cells, prog->columns);
+		table->n_rows++;
+	}
+
+	/* a dictionary's values are far fewer than the rows they were
+	 * allocated for */
+	for(c = 0; c < table->n_columns; c++) {
+		struct ligolw_columnar_column *column = &table->columns[c];
+		void *data;
+		if(!dictionaries[c].slots || !column->n_values)
+			continue;
+		data = realloc(column->offsets, column->n_values * sizeof(*column->offsets));
+		if(data)
+			column->offsets = data;
+		data = realloc(column->lengths, column->n_values * sizeof(*column->lengths));
+		if(data)
+			column->lengths = data;
+		data = realloc(column->data, column->offsets[column->n_values - 1] + column->lengths[column->n_values - 1] + 1);
+		if(data)
+			column->data = data;
+	}
+
+	columnar_dictionaries_free(table, dictionaries);
+	ligolw_stream_index_free(index);
+	free(sizes);
+	free(tokens);
+	free(cells);
+	free(selected);
+	ligolw_table_filter_free(prog);
+	ligolw_table_free(header);
+	return table;
+
+error:
+	if(prog && cells)
+		ligolw_table_free_cells(header, cells, prog->columns);
+	columnar_dictionaries_free(table, dictionaries);
+	ligolw_stream_index_free(index);
+	free(sizes);
+	free(tokens);
+	free(cells);
+	free(selected);
+	ligolw_table_filter_free(prog);
+	ligolw_table_free(header);
+	ligolw_columnar_table_free(table);
+	return NULL;
+}
+
+
+/*
+ * Free a struct ligolw_columnar_table.
+ */
+
+
+void ligolw_columnar_table_free(struct ligolw_columnar_table *table)
+{
+	if(table) {
+		int c;
+		for(c = 0; c < table->n_columns; c++) {
+			free(table->columns[c].data);
+			free(table->columns[c].offsets);
+			free(table->columns[c].lengths);
+			free(table->columns[c].codes);
+		}
+		free(table->columns);
+	}
+	free(table);
+}
+
+
+/*
+ * Get a column by name from within a columnar table.  Returns the address
+ * of the column or NULL if there is no column by that name.
+ */
+
+
+struct ligolw_columnar_column *ligolw_columnar_table_get_column(const struct ligolw_columnar_table *table, const char *name)
+{
+	int c;
+
+	for(c = 0; c < table->n_columns; c++)
+		if(!strcmp(table->columns[c].name, name))
+			return &table->columns[c];
+
+	/* couldn't find that column name */
+	return NULL;
+}
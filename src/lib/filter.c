@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2026  agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+/*
+ * Row filters.  A struct ligolw_table_filter expression is compiled
+ * against a table's columns once, resolving column names to indexes and
+ * checking that each comparison makes sense for its column's type, so
+ * that evaluating it for each row involves no string look-ups.
+ */
+
+
+#include <complex.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <./table.h>
+#include <ezligolw/ezligolw.h>
+
+
+/*
+ * Add the expression rooted at filter to the program.  Returns the index
+ * of the expression's node, or < 0 on failure.
+ */
+
+
+static int filter_compile(struct ligolw_table_filter_prog *prog, const struct ligolw_table *table, const struct ligolw_table_filter *filter)
+{
+	struct ligolw_table_filter_node *nodes;
+	enum ligolw_cell_type type;
+	int i, a, b, c;
+
+	if(!filter)
+		return -1;
+
+	nodes = realloc(prog->nodes, (prog->n_nodes + 1) * sizeof(*nodes));
+	if(!nodes)
+		return -1;
+	prog->nodes = nodes;
+	i = prog->n_nodes++;
+	prog->nodes[i].op = filter->op;
+
+	switch(filter->op) {
+	case LIGOLW_TABLE_FILTER_AND:
+	case LIGOLW_TABLE_FILTER_OR:
+		a = filter_compile(prog, table, filter->a);
+		if(a < 0)
+			return -1;
+		b = filter_compile(prog, table, filter->b);
+		if(b < 0)
+			return -1;
+		/* prog->nodes might have moved */
+		prog->nodes[i].a = a;
+		prog->nodes[i].b = b;
+		return i;
+
+	case LIGOLW_TABLE_FILTER_EQ:
+	case LIGOLW_TABLE_FILTER_NE:
+	case LIGOLW_TABLE_FILTER_LT:
+	case LIGOLW_TABLE_FILTER_LE:
+	case LIGOLW_TABLE_FILTER_GT:
+	case LIGOLW_TABLE_FILTER_GE:
+		break;
+
+	default:
+		/* unrecognized operator */
+		return -1;
+	}
+
+	if(!filter->column)
+		return -1;
+	c = ligolw_table_get_column((struct ligolw_table *) table, filter->column, &type);
+	if(c < 0)
+		/* no column by that name */
+		return -1;
+
+	switch(type) {
+	case ligolw_cell_type_blob:
+		/* blobs can't be compared */
+		return -1;
+
+	case ligolw_cell_type_complex_8:
+	case ligolw_cell_type_complex_16:
+		/* complex numbers are not ordered */
+		if(filter->op != LIGOLW_TABLE_FILTER_EQ && filter->op != LIGOLW_TABLE_FILTER_NE)
+			return -1;
+		break;
+
+	default:
+		break;
+	}
+
+	prog->nodes[i].column = c;
+	prog->nodes[i].type = type;
+	prog->nodes[i].value = filter->value;
+	prog->columns[c] = true;
+
+	return i;
+}
+
+
+/*
+ * Compile a filter expression for use with table.  Returns the program,
+ * which must be freed with ligolw_table_filter_free(), or NULL on failure,
+ * including if the expression names a column the table does not have or
+ * compares a column in a way its type does not allow.
+ */
+
+
+struct ligolw_table_filter_prog *ligolw_table_filter_compile(const struct ligolw_table *table, const struct ligolw_table_filter *filter)
+{
+	struct ligolw_table_filter_prog *prog = malloc(sizeof(*prog));
+
+	if(!prog)
+		return NULL;
+	prog->columns = calloc(table->n_columns + 1, sizeof(*prog->columns));
+	prog->n_nodes = 0;
+	prog->nodes = NULL;
+	if(!prog->columns || filter_compile(prog, table, filter) < 0) {
+		ligolw_table_filter_free(prog);
+		return NULL;
+	}
+
+	return prog;
+}
+
+
+/*
+ * Free a compiled filter.
+ */
+
+
+void ligolw_table_filter_free(struct ligolw_table_filter_prog *prog)
+{
+	if(prog) {
+		free(prog->columns);
+		free(prog->nodes);
+	}
+	free(prog);
+}
+
+
+/*
+ * Compare a cell to a comparison node's value.  Returns < 0, 0, or > 0 if
+ * the cell is less than, equal to, or greater than the value, or 2 if the
+ * two are not ordered (a NaN, or complex numbers that differ).
+ */
+
+
+static int filter_compare(const struct ligolw_table_filter_node *node, const union ligolw_cell *cell)
+{
+	switch(node->type) {
+	case ligolw_cell_type_char_s:
+	case ligolw_cell_type_char_v:
+	case ligolw_cell_type_ilwdchar:
+	case ligolw_cell_type_ilwdchar_u:
+	case ligolw_cell_type_lstring: {
+		int result = strcmp(cell->as_string ? cell->as_string : "", node->value.as_string ? node->value.as_string : "");
+		return result < 0 ? -1 : result > 0;
+	}
+
+	case ligolw_cell_type_int_2s:
+	case ligolw_cell_type_int_4s:
+	case ligolw_cell_type_int_8s:
+		return cell->as_int < node->value.as_int ? -1 : cell->as_int > node->value.as_int;
+
+	case ligolw_cell_type_int_2u:
+	case ligolw_cell_type_int_4u:
+	case ligolw_cell_type_int_8u:
+		return cell->as_uint < node->value.as_uint ? -1 : cell->as_uint > node->value.as_uint;
+
+	case ligolw_cell_type_real_4:
+	case ligolw_cell_type_real_8:
+		if(cell->as_double < node->value.as_double)
+			return -1;
+		if(cell->as_double > node->value.as_double)
+			return 1;
+		return cell->as_double == node->value.as_double ? 0 : 2;
+
+	case ligolw_cell_type_complex_8:
+	case ligolw_cell_type_complex_16:
+		return cell->as_double_complex == node->value.as_double_complex ? 0 : 2;
+
+	default:
+		/* not reached, ruled out by filter_compile() */
+		return 2;
+	}
+}
+
+
+static bool filter_eval(const struct ligolw_table_filter_prog *prog, int i, const union ligolw_cell *cells)
+{
+	const struct ligolw_table_filter_node *node = &prog->nodes[i];
+	int result;
+
+	switch(node->op) {
+	case LIGOLW_TABLE_FILTER_AND:
+		return filter_eval(prog, node->a, cells) && filter_eval(prog, node->b, cells);
+
+	case LIGOLW_TABLE_FILTER_OR:
+		return filter_eval(prog, node->a, cells) || filter_eval(prog, node->b, cells);
+
+	default:
+		break;
+	}
+
+	result = filter_compare(node, &cells[node->column]);
+	switch(node->op) {
+	case LIGOLW_TABLE_FILTER_EQ:
+		return result == 0;
+	case LIGOLW_TABLE_FILTER_NE:
+		return result != 0;
+	case LIGOLW_TABLE_FILTER_LT:
+		return result == -1;
+	case LIGOLW_TABLE_FILTER_LE:
+		return result == -1 || result == 0;
+	case LIGOLW_TABLE_FILTER_GT:
+		return result == 1;
+	case LIGOLW_TABLE_FILTER_GE:
+		return result == 1 || result == 0;
+	default:
+		return false;
+	}
+}
+
+
+/*
+ * Evaluate a compiled filter for one row.  cells must contain the decoded
+ * values of (at least) the columns for which prog->columns is true.
+ * Returns true if the row passes the filter.
+ */
+
+
+bool ligolw_table_filter_eval(const struct ligolw_table_filter_prog *prog, const union ligolw_cell *cells)
+{
+	return filter_eval(prog, 0, cells);
+}
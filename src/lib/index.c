@@ -0,0 +1,662 @@
+/*
+ * Copyright (C) 2026  agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+/*
+ * Byte-offset index of the LIGO_LW, Table, Array, Param, Time and Stream
+ * elements in an uncompressed document.  The index can be saved to a
+ * small sidecar file, and used to load one element from the document with
+ * a few pread()s instead of parsing the whole thing.
+ *
+ * Like the streaming reader, the scanner used to build the index is not a
+ * general purpose XML parser.  It understands just enough of the syntax
+ * to find start and end tags and skip everything else, and does not
+ * decode entities in Name attributes.  gzip-compressed documents cannot
+ * be indexed because offsets into them can't be seeked to.
+ */
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <ezligolw/ezligolw.h>
+
+
+/* first line of an index file */
+#define LIGOLW_INDEX_MAGIC "ezligolw-index 2"
+
+
+/* element types recorded in the index */
+static const char *const ligolw_index_types[] = {
+	"LIGO_LW",
+	"Table",
+	"Array",
+	"Param",
+	"Time",
+	"Stream",
+	NULL
+};
+
+
+/*
+ * Return the entry of ligolw_index_types matching the n characters at
+ * type, or NULL if the element type is not indexed.
+ */
+
+
+static const char *ligolw_index_type(const char *type, size_t n)
+{
+	const char *const *t;
+
+	for(t = ligolw_index_types; *t; t++)
+		if(strlen(*t) == n && !strncmp(*t, type, n))
+			return *t;
+	return NULL;
+}
+
+
+/*
+ * Return the address of the first occurance of str in [s, e) or NULL if
+ * not found.
+ */
+
+
+static const char *ligolw_index_find(const char *s, const char *e, const char *str)
+{
+	size_t n = strlen(str);
+
+	for(; (s = memchr(s, *str, e - s)) && (size_t) (e - s) >= n; s++)
+		if(!memcmp(s, str, n))
+			return s;
+	return NULL;
+}
+
+
+/*
+ * Return the address following the end of the markup starting at s, which
+ * must point to a '<', skipping quoted strings and, in a DOCTYPE
+ * declaration, the internal subset.  Returns NULL if the markup is not
+ * terminated.
+ */
+
+
+static const char *ligolw_index_skip_markup(const char *s, const char *e)
+{
+	int depth = 0;
+
+	for(s++; s < e; s++)
+		switch(*s) {
+		case '"':
+		case '\'':
+			s = memchr(s + 1, *s, e - s - 1);
+			if(!s)
+				return NULL;
+			break;
+
+		case '[':
+			depth++;
+			break;
+
+		case ']':
+			depth--;
+			break;
+
+		case '>':
+			if(depth <= 0)
+				return s + 1;
+			break;
+		}
+	return NULL;
+}
+
+
+/*
+ * Find the value of the Name attribute in the start tag [s, e).  Returns
+ * a newly-allocated copy, or NULL if there is no Name attribute.
+ */
+
+
+static char *ligolw_index_name_attr(const char *s, const char *e)
+{
+	const char *n;
+
+	for(s += strcspn(s, " \t\r\n>"); s < e; s = n + 1) {
+		const char *a;
+
+		s += strspn(s, " \t\r\n");
+		a = s;
+		s = memchr(s, '=', e - s);
+		if(!s)
+			return NULL;
+		n = s - 1;
+		while(n > a && strchr(" \t\r\n", *n))
+			n--;
+		s += 1 + strspn(s + 1, " \t\r\n");
+		if(s >= e || (*s != '"' && *s != '\''))
+			return NULL;
+		n = memchr(s + 1, *s, e - s - 1);
+		if(!n)
+			return NULL;
+		if(!strncmp(a, "Name", 4) && s - a >= 5 && strchr(" \t\r\n=", a[4]))
+			return strndup(s + 1, n - s - 1);
+	}
+	return NULL;
+}
+
+
+/*
+ * Append an entry to the index.  Returns its index or -1 on failure.
+ */
+
+
+static int ligolw_index_append(struct ligolw_index *index, const char *type, char *name, int parent, off_t offset, size_t head)
+{
+	struct ligolw_index_entry *entries;
+
+	if(!(index->n_entries & (index->n_entries - 1))) {
+		entries = realloc(index->entries, (index->n_entries ? 2 * index->n_entries : 1) * sizeof(*entries));
+		if(!entries)
+			return -1;
+		index->entries = entries;
+	}
+
+	entries = &index->entries[index->n_entries];
+	entries->type = type;
+	entries->name = name;
+	entries->parent = parent;
+	entries->offset = offset;
+	entries->length = head;
+	entries->head = head;
+
+	return index->n_entries++;
+}
+
+
+/*
+ * Scan the document [s, e) and fill in the index entries.  Returns 0 on
+ * success, or -1 if the document is malformed or memory cannot be
+ * allocated.
+ */
+
+
+static int ligolw_index_scan(struct ligolw_index *index, const char *s, const char *e)
+{
+	const char *start = s;
+	/* for each open element, its entry in the index or -1 if it is not
+	 * indexed, and the entry of the nearest indexed ancestor */
+	struct {
+		int entry;
+		int parent;
+	} *stack = NULL, *new;
+	int depth = 0, size = 0;
+	int root_seen = 0;
+
+	while(s < e && (s = memchr(s, '<', e - s))) {
+		const char *end;
+
+		if(e - s >= 4 && !memcmp(s, "<!--", 4))
+			end = (end = ligolw_index_find(s + 4, e, "-->")) ? end + 3 : NULL;
+		else if(e - s >= 9 && !memcmp(s, "<![CDATA[", 9))
+			end = (end = ligolw_index_find(s + 9, e, "]]>")) ? end + 3 : NULL;
+		else if(e - s >= 2 && !memcmp(s, "<?", 2))
+			end = (end = ligolw_index_find(s + 2, e, "?>")) ? end + 2 : NULL;
+		else
+			end = ligolw_index_skip_markup(s, e);
+		if(!end)
+			goto error;
+
+		if(s[1] == '/') {
+			/* end tag */
+			if(!depth)
+				goto error;
+			depth--;
+			if(stack[depth].entry >= 0)
+				index->entries[stack[depth].entry].length = end - start - index->entries[stack[depth].entry].offset;
+		} else if(s[1] != '!' && s[1] != '?') {
+			/* start tag or empty-element tag */
+			size_t n = strcspn(s + 1, " \t\r\n/>");
+			const char *type = ligolw_index_type(s + 1, n);
+			int parent = depth ? stack[depth - 1].parent : -1;
+			int entry = -1;
+
+			if(!root_seen) {
+				index->prolog = s - start;
+				root_seen = 1;
+			} else if(!depth)
+				/* more than one root element */
+				goto error;
+
+			if(type) {
+				char *name = ligolw_index_name_attr(s, end - 1);
+				entry = ligolw_index_append(index, type, name, parent, s - start, end - s);
+				if(entry < 0) {
+					free(name);
+					goto error;
+				}
+				parent = entry;
+			}
+
+			if(end[-2] != '/') {
+				if(depth >= size) {
+					new = realloc(stack, (size = size ? 2 * size : 16) * sizeof(*stack));
+					if(!new)
+						goto error;
+					stack = new;
+				}
+				stack[depth].entry = entry;
+				stack[depth].parent = parent;
+				depth++;
+			}
+		}
+
+		s = end;
+	}
+
+	free(stack);
+	return root_seen && !depth ? 0 : -1;
+
+error:
+	free(stack);
+	return -1;
+}
+
+
+/*
+ * Return 0 if the index was built from the file as it is now, or -1 if
+ * the file has been modified or can't be stat()ed.
+ */
+
+
+static int ligolw_index_check(const struct ligolw_index *index, int fd)
+{
+	struct stat st;
+
+	if(fstat(fd, &st) || st.st_size != index->size || st.st_mtime != index->mtime || st.st_mtim.tv_nsec != index->mtime_nsec)
+		return -1;
+	return 0;
+}
+
+
+/*
+ * Allocate an empty index.
+ */
+
+
+static struct ligolw_index *ligolw_index_new(void)
+{
+	struct ligolw_index *index = malloc(sizeof(*index));
+
+	if(!index)
+		return NULL;
+	index->size = 0;
+	index->mtime = 0;
+	index->mtime_nsec = 0;
+	index->prolog = 0;
+	index->n_entries = 0;
+	index->entries = NULL;
+
+	return index;
+}
+
+
+/*
+ * Free an index.
+ */
+
+
+void ligolw_index_free(struct ligolw_index *index)
+{
+	if(index) {
+		int i;
+		for(i = 0; i < index->n_entries; i++)
+			free((char *) index->entries[i].name);
+		free(index->entries);
+	}
+	free(index);
+}
+
+
+/*
+ * Build the index of a file.  The file is mapped read-only and only its
+ * markup is examined.  Returns NULL on failure, including if the file is
+ * gzip-compressed or is not well-formed.
+ */
+
+
+struct ligolw_index *ligolw_index_build(const char *filename)
+{
+	struct ligolw_index *index;
+	struct stat st;
+	void *map;
+	int fd;
+
+	fd = open(filename, O_RDONLY);
+	if(fd < 0)
+		return NULL;
+	if(fstat(fd, &st) || !st.st_size) {
+		close(fd);
+		return NULL;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED)
+		return NULL;
+	posix_madvise(map, st.st_size, POSIX_MADV_SEQUENTIAL);
+
+	index = ligolw_index_new();
+	if(index) {
+		index->size = st.st_size;
+		index->mtime = st.st_mtime;
+		index->mtime_nsec = st.st_mtim.tv_nsec;
+		/* gzip magic number, or not an XML document */
+		if((st.st_size >= 2 && !memcmp(map, "\x1f\x8b", 2)) || ligolw_index_scan(index, map, (const char *) map + st.st_size)) {
+			ligolw_index_free(index);
+			index = NULL;
+		}
+	}
+
+	munmap(map, st.st_size);
+	return index;
+}
+
+
+/*
+ * Write an index to a file.  One line of text is written for each entry.
+ * The index is written to a temporary file in the same directory, which
+ * is then renamed to filename, so a process reading the file while
+ * another is writing it, as can happen when two of them
+ * ligolw_index_open() the same document at once, sees either the old file
+ * or the complete new one.  Returns 0 on success, -1 on failure.
+ */
+
+
+int ligolw_index_write(const struct ligolw_index *index, const char *filename)
+{
+	char *tmp = malloc(strlen(filename) + 32);
+	FILE *f;
+	int fd = -1;
+	int i;
+
+	if(!tmp)
+		return -1;
+	for(i = 0; fd < 0 && i < 100; i++) {
+		sprintf(tmp, "%s.%ld.%d", filename, (long) getpid(), i);
+		fd = open(tmp, O_WRONLY | O_CREAT | O_EXCL, 0666);
+		if(fd < 0 && errno != EEXIST)
+			break;
+	}
+	if(fd < 0) {
+		free(tmp);
+		return -1;
+	}
+	f = fdopen(fd, "w");
+	if(!f) {
+		close(fd);
+		goto error;
+	}
+
+	fprintf(f, LIGOLW_INDEX_MAGIC " %lld %lld %ld %zu %d\n", (long long) index->size, (long long) index->mtime, index->mtime_nsec, index->prolog, index->n_entries);
+	for(i = 0; i < index->n_entries; i++) {
+		const struct ligolw_index_entry *entry = &index->entries[i];
+		/* the Name goes last since it could contain spaces */
+		fprintf(f, "%d %lld %zu %zu %s %s\n", entry->parent, (long long) entry->offset, entry->length, entry->head, entry->type, entry->name ? entry->name : "");
+	}
+
+	if(ferror(f)) {
+		fclose(f);
+		goto error;
+	}
+	if(fclose(f) || rename(tmp, filename))
+		goto error;
+
+	free(tmp);
+	return 0;
+
+error:
+	unlink(tmp);
+	free(tmp);
+	return -1;
+}
+
+
+/*
+ * Read an index previously written by ligolw_index_write().  If document
+ * is not NULL, the index is checked against that file.  Returns NULL on
+ * failure, including if the index is malformed or if document has been
+ * modified since the index was built.
+ */
+
+
+struct ligolw_index *ligolw_index_read(const char *filename, const char *document)
+{
+	struct ligolw_index *index;
+	FILE *f;
+	char *line = NULL;
+	size_t line_size = 0;
+	ssize_t len;
+	long long size, mtime;
+	int n_entries;
+	int n;
+
+	f = fopen(filename, "r");
+	if(!f)
+		return NULL;
+	index = ligolw_index_new();
+	if(!index)
+		goto error;
+
+	if(getline(&line, &line_size, f) < 0 || sscanf(line, LIGOLW_INDEX_MAGIC " %lld %lld %ld %zu %d", &size, &mtime, &index->mtime_nsec, &index->prolog, &n_entries) != 5)
+		goto error;
+	index->size = size;
+	index->mtime = mtime;
+
+	while((len = getline(&line, &line_size, f)) > 0) {
+		long long offset;
+		size_t length, head;
+		int parent;
+		const char *type;
+		char *name = NULL;
+		int i;
+
+		if(line[len - 1] == '\n')
+			line[--len] = '\0';
+		n = -1;
+		sscanf(line, "%d %lld %zu %zu %n", &parent, &offset, &length, &head, &n);
+		if(n < 0 || parent < -1 || parent >= index->n_entries)
+			goto error;
+		type = ligolw_index_type(line + n, strcspn(line + n, " "));
+		if(!type)
+			goto error;
+		n += strlen(type);
+		if(line[n] == ' ' && line[n + 1]) {
+			name = strdup(line + n + 1);
+			if(!name)
+				goto error;
+		}
+
+		i = ligolw_index_append(index, type, name, parent, offset, head);
+		if(i < 0) {
+			free(name);
+			goto error;
+		}
+		index->entries[i].length = length;
+	}
+	/* a truncated file */
+	if(ferror(f) || index->n_entries != n_entries)
+		goto error;
+
+	free(line);
+	fclose(f);
+
+	if(document) {
+		int fd = open(document, O_RDONLY);
+		n = fd >= 0 ? ligolw_index_check(index, fd) : -1;
+		if(fd >= 0)
+			close(fd);
+		if(n) {
+			ligolw_index_free(index);
+			return NULL;
+		}
+	}
+
+	return index;
+
+error:
+	free(line);
+	fclose(f);
+	ligolw_index_free(index);
+	return NULL;
+}
+
+
+/*
+ * Return the index of a file, reading it from the sidecar file
+ * "filename.idx" if that exists and is up to date, otherwise building it
+ * and attempting to (re)write the sidecar file.  Failure to write the
+ * sidecar file is not an error.  Returns NULL on failure.
+ */
+
+
+struct ligolw_index *ligolw_index_open(const char *filename)
+{
+	struct ligolw_index *index;
+	char *sidecar = malloc(strlen(filename) + 5);
+
+	if(!sidecar)
+		return NULL;
+	strcat(strcpy(sidecar, filename), ".idx");
+
+	index = ligolw_index_read(sidecar, filename);
+	if(!index) {
+		index = ligolw_index_build(filename);
+		if(index)
+			ligolw_index_write(index, sidecar);
+	}
+
+	free(sidecar);
+	return index;
+}
+
+
+/*
+ * Return the first entry in the index for an element of the given type
+ * whose Name attribute matches name as in ligolw_elem_iter(), or NULL if
+ * there is none.  If name is NULL the first element of the given type is
+ * returned.
+ */
+
+
+const struct ligolw_index_entry *ligolw_index_find_entry(const struct ligolw_index *index, const char *type, const char *name)
+{
+	int n = name ? strlen(name) : 0;
+	int i;
+
+	for(i = 0; i < index->n_entries; i++)
+		if(!strcmp(index->entries[i].type, type) && (!name || (index->entries[i].name && !strncmp(ligolw_strip_name(index->entries[i].name, NULL), name, n))))
+			return &index->entries[i];
+	return NULL;
+}
+
+
+/*
+ * Read len bytes at offset from fd into buf.  Returns 0 on success, -1 on
+ * failure.
+ */
+
+
+static int ligolw_index_pread(int fd, char *buf, size_t len, off_t offset)
+{
+	while(len) {
+		ssize_t l = pread(fd, buf, len, offset);
+		if(l <= 0)
+			return -1;
+		buf += l;
+		len -= l;
+		offset += l;
+	}
+	return 0;
+}
+
+
+/*
+ * Load one element from the indexed file.  The result is a document
+ * containing the file's prolog (so entity declarations and default
+ * attributes from an internal DTD subset still apply), the start tags of
+ * the element's indexed ancestors, and the element itself, so
+ * ligolw_table_get(), ligolw_array_get(), etc., can be used on it as on
+ * the whole document.  The calling code owns the result and must free it
+ * with ezxml_free().  Returns NULL on failure, including if the element is
+ * not in the index or the file has been modified since the index was
+ * built.
+ */
+
+
+ezxml_t ligolw_index_load(const struct ligolw_index *index, const char *filename, const char *type, const char *name)
+{
+	const struct ligolw_index_entry *entry = ligolw_index_find_entry(index, type, name);
+	const struct ligolw_index_entry *e;
+	size_t heads = 0, tails = 0;
+	size_t len;
+	char *buf, *s, *t;
+	int fd;
+
+	if(!entry)
+		return NULL;
+
+	/* the prolog, the start and end tags of the ancestors, and the
+	 * element */
+	for(e = entry; e->parent >= 0; ) {
+		e = &index->entries[e->parent];
+		heads += e->head;
+		tails += strlen(e->type) + 3;
+	}
+	len = index->prolog + heads + entry->length + tails;
+
+	fd = open(filename, O_RDONLY);
+	if(fd < 0)
+		return NULL;
+	buf = malloc(len);
+	if(!buf || ligolw_index_check(index, fd) || ligolw_index_pread(fd, buf, index->prolog, 0) || ligolw_index_pread(fd, buf + index->prolog + heads, entry->length, entry->offset))
+		goto error;
+
+	/* working outwards from the element, its ancestors' start tags go
+	 * before it and their end tags after it */
+	s = buf + index->prolog + heads;
+	t = s + entry->length;
+	for(e = entry; e->parent >= 0; ) {
+		e = &index->entries[e->parent];
+		s -= e->head;
+		if(ligolw_index_pread(fd, s, e->head, e->offset))
+			goto error;
+		t += sprintf(t, "</%s", e->type);
+		*t++ = '>';
+	}
+	close(fd);
+
+	return ezxml_parse_str_m(buf, len);
+
+error:
+	free(buf);
+	close(fd);
+	return NULL;
+}
@@ -33,6 +33,7 @@
 union ligolw_cell ligolw_param_parse(ezxml_t elem, enum ligolw_cell_type *type)
 {
 	const char *type_name = ezxml_attr(elem, "Type");
+	const char *txt;
 	union ligolw_cell value;
 
 	if(!type_name)
@@ -40,7 +41,9 @@ union ligolw_cell ligolw_param_parse(ezxml_t elem, enum ligolw_cell_type *type)
 		type_name = "lstring";
 
 	*type = ligolw_type_name_to_enum(type_name);
-	ligolw_cell_from_txt(&value, *type, elem->txt);
+	/* decode first, ezxml_txt_len() is the decoded length */
+	txt = ezxml_txt_decode(elem);
+	ligolw_cell_from_txtn(&value, *type, txt ? txt : "", txt ? ezxml_txt_len(elem) : 0);
 
 	return value;
 }
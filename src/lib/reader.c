@@ -0,0 +1,751 @@
+/*
+ * Copyright (C) 2026  agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+/*
+ * Event-driven (streaming) Table reader.  Reads a document from disk in
+ * fixed-size chunks, never building the ezxml tree, and hands rows to the
+ * row_callback() as they are completed.  Peak memory use is roughly one
+ * chunk of input plus the text of one row, regardless of the size of the
+ * document.
+ *
+ * This is not a general purpose XML parser.  It understands just enough
+ * of the syntax to find Table, Column and Stream elements and to skip
+ * everything else.  Only the pre-defined entities (&lt; &gt; &amp; &quot;
+ * &apos;) and character references are decoded;  entities declared in an
+ * internal DTD subset are left undecoded.  UTF-16 documents are not
+ * supported.
+ */
+
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include <./stream.h>
+#include <./table.h>
+#include <ezligolw/ezligolw.h>
+
+
+/* number of bytes requested from the file at a time */
+#ifndef LIGOLW_READER_CHUNK
+#define LIGOLW_READER_CHUNK 1048576
+#endif
+
+
+struct ligolw_reader {
+	gzFile f;
+	/* input buffer.  always null-terminated at len */
+	char *buf;
+	size_t size;
+	/* offset of first unconsumed byte, and of the end of the data */
+	size_t pos;
+	size_t len;
+	int eof;
+
+	/* the Table being read */
+	const char *name;
+	ezxml_t header;
+	struct ligolw_table *table;
+	const struct ligolw_table_options *options;
+	/* columns to convert, NULL for all, and the compiled filter */
+	bool *selected;
+	struct ligolw_table_filter_prog *prog;
+	int (*row_callback)(struct ligolw_table *, struct ligolw_table_row *, void *);
+	void *callback_data;
+
+	/* decoded Stream text not yet tokenized.  tok_start is the offset
+	 * of the current token's first character, tok_scan the offset to
+	 * which the text has been scanned for the token's end */
+	char *tok;
+	size_t tok_size;
+	size_t tok_len;
+	size_t tok_start;
+	size_t tok_scan;
+	enum {
+		tok_space,
+		tok_unquoted,
+		tok_quoted,
+		tok_escape,
+		tok_closed
+	} tok_state;
+
+	/* the row being assembled */
+	struct ligolw_table_row *row;
+	int n_cells;
+};
+
+
+/*
+ * Read more data into the buffer, discarding the consumed portion.  The
+ * buffer is grown if it is full, so that any single markup construct can
+ * be made to fit.  Returns the number of bytes added, 0 at the end of the
+ * file, < 0 on error.
+ */
+
+
+static int reader_fill(struct ligolw_reader *r)
+{
+	int n;
+
+	if(r->eof)
+		return 0;
+
+	if(r->pos) {
+		memmove(r->buf, r->buf + r->pos, r->len - r->pos);
+		r->len -= r->pos;
+		r->pos = 0;
+	}
+
+	if(r->size - r->len < LIGOLW_READER_CHUNK) {
+		char *buf = realloc(r->buf, r->len + LIGOLW_READER_CHUNK + 1);
+		if(!buf)
+			return -1;
+		r->buf = buf;
+		r->size = r->len + LIGOLW_READER_CHUNK;
+	}
+
+	n = gzread(r->f, r->buf + r->len, LIGOLW_READER_CHUNK);
+	if(n < 0)
+		return -1;
+	if(!n)
+		r->eof = 1;
+	r->len += n;
+	r->buf[r->len] = '\0';
+
+	return n;
+}
+
+
+/*
+ * Ensure at least n unconsumed bytes are in the buffer, unless the end of
+ * the file is reached first.  Returns < 0 on error.
+ */
+
+
+static int reader_require(struct ligolw_reader *r, size_t n)
+{
+	while(r->len - r->pos < n && !r->eof)
+		if(reader_fill(r) < 0)
+			return -1;
+	return 0;
+}
+
+
+/*
+ * Find the end of the markup construct starting at the current position.
+ * terminator is the string that ends it ("-->", "?>", etc.).  If quoted is
+ * true, terminators inside quoted attribute values are ignored;  if
+ * brackets is true, terminators inside a [...] internal DTD subset are
+ * ignored.  Returns the offset from r->pos of the first character
+ * following the terminator, or 0 if the end of the file is reached first,
+ * or < 0 on error.
+ */
+
+
+static long reader_find_end(struct ligolw_reader *r, const char *terminator, bool quoted, bool brackets)
+{
+	size_t n = strlen(terminator);
+	size_t i = 1;
+	char quote = '\0';
+	int depth = 0;
+
+	for(;;) {
+		for(; r->pos + i + n <= r->len; i++) {
+			char c = r->buf[r->pos + i];
+			if(quote) {
+				if(c == quote)
+					quote = '\0';
+			} else if(quoted && (c == '"' || c == '\'')) {
+				quote = c;
+			} else if(brackets && c == '[') {
+				depth++;
+			} else if(brackets && c == ']' && depth) {
+				depth--;
+			} else if(!depth && !memcmp(r->buf + r->pos + i, terminator, n))
+				return i + n;
+		}
+		if(r->eof)
+			return 0;
+		if(reader_fill(r) < 0)
+			return -1;
+	}
+}
+
+
+/*
+ * Decode one character or pre-defined entity reference.  s points to the
+ * '&'.  Writes the replacement text to d and returns the number of bytes
+ * written, and sets *end to the first character following the reference.
+ * Returns 0 if s does not start a recognized reference.  Mirrors the
+ * character reference handling in ezxml_decode().
+ */
+
+
+static int reader_decode_ref(const char *s, const char **end, char *d)
+{
+	static const struct {
+		const char *name;
+		char c;
+	} entities[] = {
+		{"lt;", '<'},
+		{"gt;", '>'},
+		{"amp;", '&'},
+		{"quot;", '"'},
+		{"apos;", '\''},
+		{NULL, '\0'}
+	};
+	int i;
+
+	if(s[1] == '#') {
+		char *e;
+		long c = s[2] == 'x' ? strtol(s + 3, &e, 16) : strtol(s + 2, &e, 10);
+		long b, k;
+		if(!c || *e != ';')
+			return 0;
+		*end = e + 1;
+		if(c < 0x80) {
+			*d = c;
+			return 1;
+		}
+		/* multi-byte UTF-8 sequence */
+		for(b = 0, k = c; k; k /= 2)
+			b++;
+		b = (b - 2) / 5;
+		d[0] = (0xFF << (7 - b)) | (c >> (6 * b));
+		for(i = 1; b; i++)
+			d[i] = 0x80 | ((c >> (6 * --b)) & 0x3F);
+		return i;
+	}
+
+	for(i = 0; entities[i].name; i++)
+		if(!strncmp(s + 1, entities[i].name, strlen(entities[i].name))) {
+			*end = s + 1 + strlen(entities[i].name);
+			*d = entities[i].c;
+			return 1;
+		}
+
+	return 0;
+}
+
+
+/*
+ * Decode the character content in [s, e) and append it to the token
+ * buffer.  If cdata is true only line endings are normalized.  If final is
+ * false, the text is known to be followed by more character content, and
+ * a trailing '\r' or incomplete reference is left unconsumed.  Returns the
+ * address of the first unconsumed character, or NULL on error.
+ */
+
+
+static const char *reader_append_text(struct ligolw_reader *r, const char *s, const char *e, bool cdata, bool final)
+{
+	const char *amp, *cr;
+	char *d;
+
+	/* decoding never makes text longer */
+	if(r->tok_size - r->tok_len < (size_t) (e - s) + 1) {
+		char *tok = realloc(r->tok, r->tok_len + (e - s) + 1);
+		if(!tok)
+			return NULL;
+		r->tok = tok;
+		r->tok_size = r->tok_len + (e - s) + 1;
+	}
+	d = r->tok + r->tok_len;
+
+	/* the next '&' and '\r' at or after s, or e if none */
+	amp = cdata ? e : s;
+	cr = s;
+	while(s < e) {
+		const char *stop;
+
+		if(amp < s || (amp == s && *s != '&'))
+			amp = memchr(s, '&', e - s);
+		if(!amp)
+			amp = e;
+		if(cr < s || (cr == s && *s != '\r'))
+			cr = memchr(s, '\r', e - s);
+		if(!cr)
+			cr = e;
+		stop = cr < amp ? cr : amp;
+
+		memcpy(d, s, stop - s);
+		d += stop - s;
+		s = stop;
+
+		if(s == e)
+			break;
+		if(*s == '\r') {
+			/* normalize "\r\n" and "\r" to "\n" */
+			if(s + 1 == e && !final)
+				break;
+			*d++ = '\n';
+			s += s + 1 < e && s[1] == '\n' ? 2 : 1;
+		} else {
+			/* '&'.  the longest reference is shorter than 16
+			 * characters;  if one might be truncated, wait for
+			 * more text */
+			const char *end;
+			int n;
+			if(!final && e - s < 16 && !memchr(s, ';', e - s))
+				break;
+			n = reader_decode_ref(s, &end, d);
+			if(n && end <= e) {
+				d += n;
+				s = end;
+			} else
+				*d++ = *s++;
+		}
+	}
+
+	r->tok_len = d - r->tok;
+	r->tok[r->tok_len] = '\0';
+
+	return s;
+}
+
+
+/*
+ * Convert one token into the next cell of the current row, and hand the
+ * row to the row_callback() if it is complete.  txt must be a
+ * null-terminated string containing exactly one token.  Returns < 0 on
+ * error.
+ */
+
+
+static int reader_cell(struct ligolw_reader *r, const char *txt)
+{
+	struct ligolw_table *table = r->table;
+	const char *start, *stop;
+	int escapes;
+
+	if(!table->n_columns)
+		return -1;
+
+	if(!r->row) {
+		r->row = malloc(sizeof(*r->row));
+		if(!r->row)
+			return -1;
+		r->row->table = table;
+		r->row->cells = calloc(table->n_columns, sizeof(*r->row->cells));
+		if(!r->row->cells) {
+			free(r->row);
+			r->row = NULL;
+			return -1;
+		}
+		r->n_cells = 0;
+	}
+
+	escapes = ligolw_stream_next_token(&txt, txt + strlen(txt), &start, &stop, table->delimiter);
+	if(escapes < 0)
+		return -1;
+	if((!r->selected || r->selected[r->n_cells] || (r->prog && r->prog->columns[r->n_cells])) && !ligolw_stream_token_to_cell(&r->row->cells[r->n_cells], table->columns[r->n_cells].type, start, stop, escapes)) {
+		/* not a valid value of the column's type */
+		return -1;
+	}
+
+	if(++r->n_cells == table->n_columns) {
+		struct ligolw_table_row *row = r->row;
+		if(r->prog && !ligolw_table_filter_eval(r->prog, row->cells)) {
+			/* rejected.  re-use the row */
+			ligolw_table_free_cells(table, row->cells, NULL);
+			r->n_cells = 0;
+			return 0;
+		}
+		r->row = NULL;
+		r->n_cells = 0;
+		/* row_callback takes ownership of row */
+		if(r->row_callback(table, row, r->callback_data))
+			return -1;
+	}
+
+	return 0;
+}
+
+
+/*
+ * Split the decoded Stream text accumulated so far into tokens, and
+ * convert each complete token.  If final is true, the end of the Stream
+ * has been reached and the remaining text is the last token.  Returns < 0
+ * on error.
+ */
+
+
+static int reader_tokenize(struct ligolw_reader *r, bool final)
+{
+	char delimiter = r->table->delimiter;
+
+	for(; r->tok_scan < r->tok_len; r->tok_scan++) {
+		char c = r->tok[r->tok_scan];
+
+		switch(r->tok_state) {
+		case tok_space:
+			if(isspace(c) && c != delimiter)
+				continue;
+			r->tok_state = c == '"' ? tok_quoted : tok_unquoted;
+			if(c != delimiter)
+				continue;
+			break;
+
+		case tok_quoted:
+			if(c == '\\')
+				r->tok_state = tok_escape;
+			else if(c == '"')
+				r->tok_state = tok_closed;
+			continue;
+
+		case tok_escape:
+			r->tok_state = tok_quoted;
+			continue;
+
+		case tok_unquoted:
+		case tok_closed:
+			if(c != delimiter)
+				continue;
+			break;
+		}
+
+		/* found the delimiter that ends the token */
+		r->tok[r->tok_scan] = '\0';
+		if(reader_cell(r, r->tok + r->tok_start) < 0)
+			return -1;
+		r->tok_start = r->tok_scan + 1;
+		r->tok_state = tok_space;
+	}
+
+	if(final) {
+		/* the last token has no delimiter following it.  trailing
+		 * white space at a row boundary is not a token */
+		if(r->tok_state != tok_space || r->n_cells)
+			if(reader_cell(r, r->tok + r->tok_start) < 0)
+				return -1;
+		/* like ligolw_table_parse(), an incomplete final row is
+		 * padded with empty tokens */
+		while(r->n_cells) {
+			char empty[] = "";
+			if(reader_cell(r, empty) < 0)
+				return -1;
+		}
+		r->tok_len = r->tok_start = r->tok_scan = 0;
+		r->tok_state = tok_space;
+		return 0;
+	}
+
+	/* discard the consumed text */
+	memmove(r->tok, r->tok + r->tok_start, r->tok_len - r->tok_start + 1);
+	r->tok_len -= r->tok_start;
+	r->tok_scan -= r->tok_start;
+	r->tok_start = 0;
+
+	return 0;
+}
+
+
+/*
+ * Parse the start tag at the current position, which is len bytes long,
+ * into a new ezxml element appended to parent.  If parent is NULL, a new
+ * root element is created.  Returns the new element or NULL on error.
+ */
+
+
+static ezxml_t reader_start_tag(struct ligolw_reader *r, ezxml_t parent, size_t len)
+{
+	char *s = r->buf + r->pos + 1;
+	char *e = r->buf + r->pos + len - 1;
+	size_t n = strcspn(s, " \t\r\n/>");
+	ezxml_t elem;
+
+	{
+	char name[n + 1];
+	memcpy(name, s, n);
+	name[n] = '\0';
+	elem = parent ? ezxml_add_child_d(parent, name, 0) : ezxml_new_d(name);
+	}
+	if(!elem)
+		return NULL;
+
+	for(s += n; s < e; ) {
+		char *value;
+		char quote;
+
+		s += strspn(s, " \t\r\n");
+		if(*s == '/' || s >= e)
+			break;
+		n = strcspn(s, " \t\r\n=");
+		value = s + n + strspn(s + n, " \t\r\n=");
+		quote = *value++;
+		if(value > e || (quote != '"' && quote != '\''))
+			return NULL;
+		{
+		char name[n + 1];
+		char *end = memchr(value, quote, e - value);
+		size_t tok_len = r->tok_len;
+		memcpy(name, s, n);
+		name[n] = '\0';
+		/* borrow the token buffer to decode the value */
+		if(!end || !reader_append_text(r, value, end, false, true))
+			return NULL;
+		{
+		char *c;
+		for(c = r->tok + tok_len; *c; c++)
+			if(isspace(*c))
+				*c = ' ';
+		}
+		ezxml_set_attr_d(elem, name, r->tok + tok_len);
+		r->tok_len = tok_len;
+		s = end + 1;
+		}
+	}
+
+	return elem;
+}
+
+
+/*
+ * Does the Table element's Name match the one being sought?
+ */
+
+
+static bool reader_name_matches(struct ligolw_reader *r, ezxml_t elem)
+{
+	if(!r->name)
+		return true;
+	return !strncmp(ligolw_strip_name(ezxml_attr(elem, "Name"), NULL), r->name, strlen(r->name));
+}
+
+
+/*
+ * Construct the struct ligolw_table from the metadata collected so far.
+ * The table takes ownership of the XML fragment.  Returns < 0 on error.
+ */
+
+
+static int reader_new_table(struct ligolw_reader *r)
+{
+	bool failed;
+
+	r->table = ligolw_table_new(r->header);
+	if(!r->table)
+		return -1;
+	r->table->header = r->header;
+	r->selected = ligolw_table_selected_columns(r->table, r->options, &failed);
+	if(failed)
+		return -1;
+	if(r->options && r->options->filter) {
+		r->prog = ligolw_table_filter_compile(r->table, r->options->filter);
+		if(!r->prog)
+			return -1;
+	}
+	return 0;
+}
+
+
+/*
+ * Read the document.  Returns 0 when the Table has been read, > 0 if the
+ * end of the document was reached without finding it, < 0 on error.
+ */
+
+
+static int reader_run(struct ligolw_reader *r)
+{
+	enum {
+		state_search,
+		state_table,
+		state_stream
+	} state = state_search;
+
+	for(;;) {
+		char *s, *lt;
+		long len;
+
+		/*
+		 * character content
+		 */
+
+		s = r->buf + r->pos;
+		lt = memchr(s, '<', r->len - r->pos);
+		if(state == state_stream) {
+			const char *e = reader_append_text(r, s, lt ? lt : r->buf + r->len, false, lt != NULL);
+			if(!e || reader_tokenize(r, false) < 0)
+				return -1;
+			r->pos = e - r->buf;
+		} else
+			r->pos = lt ? (size_t) (lt - r->buf) : r->len;
+		if(!lt) {
+			int n = reader_fill(r);
+			if(n < 0)
+				return -1;
+			if(!n)
+				return state == state_search ? 1 : -1;
+			continue;
+		}
+
+		/*
+		 * markup
+		 */
+
+		if(reader_require(r, 9) < 0)
+			return -1;
+		s = r->buf + r->pos;
+
+		if(!strncmp(s, "<!--", 4))
+			len = reader_find_end(r, "-->", false, false);
+		else if(!strncmp(s, "<![CDATA[", 9)) {
+			len = reader_find_end(r, "]]>", false, false);
+			if(len > 0 && state == state_stream) {
+				s = r->buf + r->pos;
+				if(!reader_append_text(r, s + 9, s + len - 3, true, true) || reader_tokenize(r, false) < 0)
+					return -1;
+			}
+		} else if(s[1] == '?')
+			len = reader_find_end(r, "?>", false, false);
+		else if(s[1] == '!')
+			len = reader_find_end(r, ">", true, true);
+		else if(s[1] == '/') {
+			len = reader_find_end(r, ">", false, false);
+			if(len <= 0)
+				return -1;
+			s = r->buf + r->pos + 2;
+			if(state == state_stream && !strncmp(s, "Stream", 6) && !isalnum(s[6])) {
+				if(reader_tokenize(r, true) < 0)
+					return -1;
+				state = state_table;
+			} else if(state == state_table && !strncmp(s, "Table", 5) && !isalnum(s[5])) {
+				return r->table ? 0 : reader_new_table(r);
+			}
+		} else {
+			ezxml_t elem = NULL;
+			len = reader_find_end(r, ">", true, false);
+			if(len <= 0)
+				return -1;
+			s = r->buf + r->pos + 1;
+			switch(state) {
+			case state_search:
+				if(!strncmp(s, "Table", 5) && !isalnum(s[5])) {
+					elem = reader_start_tag(r, NULL, len);
+					if(!elem)
+						return -1;
+					if(reader_name_matches(r, elem)) {
+						r->header = elem;
+						state = state_table;
+					} else
+						ezxml_free(elem);
+				}
+				break;
+
+			case state_table:
+				if(!strncmp(s, "Column", 6) && !isalnum(s[6])) {
+					if(!reader_start_tag(r, r->header, len))
+						return -1;
+				} else if(!strncmp(s, "Stream", 6) && !isalnum(s[6])) {
+					if(!reader_start_tag(r, r->header, len) || reader_new_table(r) < 0)
+						return -1;
+					/* a self-closing Stream has no rows */
+					if(r->buf[r->pos + len - 2] != '/')
+						state = state_stream;
+				}
+				break;
+
+			case state_stream:
+				/* Stream elements have no children */
+				return -1;
+			}
+			/* a self-closing Table is an empty table */
+			if(elem && state == state_table && r->buf[r->pos + len - 2] == '/')
+				return reader_new_table(r);
+		}
+		if(len <= 0)
+			return -1;
+		r->pos += len;
+	}
+}
+
+
+/*
+ * Read the Table element named name from the file, without loading the
+ * document into memory.  The file may be gzip-compressed or not.  If name
+ * is NULL the first Table element is read, otherwise the element's Name
+ * attribute must match (ignoring an optional :... suffix), as for
+ * ligolw_table_get().  Rows are passed to row_callback() as they are
+ * completed, with the same contract as ligolw_table_parse().  If
+ * row_callback() is NULL the default row builder is used, which of course
+ * defeats the purpose of streaming the document but is permitted.
+ *
+ * Returns the address of a new struct ligolw_table describing the table's
+ * columns (and containing the rows if the default row builder was used),
+ * which the calling code must free with ligolw_table_free().  Returns NULL
+ * on failure or if no matching Table element is found.
+ */
+
+
+struct ligolw_table *ligolw_table_parse_gzfile(const char *filename, const char *name, int (row_callback)(struct ligolw_table *, struct ligolw_table_row *, void *), void *callback_data)
+{
+	return ligolw_table_parse_gzfile_opts(filename, name, NULL, row_callback, callback_data);
+}
+
+
+/*
+ * Same as ligolw_table_parse_gzfile() but with options controlling how the
+ * Table is parsed, as for ligolw_table_parse_opts().  options may be NULL.
+ * Because the rows are read a token at a time, a row's tokens are all
+ * converted before a filter is evaluated, so a filter saves only the
+ * row_callback() calls and not the conversions.  LIGOLW_TABLE_REUSE_ROW
+ * is ignored, each row is newly allocated as without it.
+ */
+
+
+struct ligolw_table *ligolw_table_parse_gzfile_opts(const char *filename, const char *name, const struct ligolw_table_options *options, int (row_callback)(struct ligolw_table *, struct ligolw_table_row *, void *), void *callback_data)
+{
+	struct ligolw_reader r;
+	int result;
+
+	memset(&r, 0, sizeof(r));
+	r.name = name;
+	r.options = options;
+	r.row_callback = row_callback ? row_callback : ligolw_table_default_row_callback;
+	r.callback_data = callback_data;
+	r.tok_state = tok_space;
+
+	r.f = gzopen(filename, "rb");
+	if(!r.f)
+		return NULL;
+	gzbuffer(r.f, 131072);
+
+	result = reader_run(&r);
+	/* an incomplete row, or one a filter rejected */
+	if(r.row) {
+		ligolw_table_free_row_data(r.table, r.row);
+		free(r.row);
+	}
+	if(result) {
+		/* once it exists, the table owns the header */
+		if(r.table)
+			ligolw_table_free(r.table);
+		else
+			ezxml_free(r.header);
+		r.table = NULL;
+	}
+
+	gzclose(r.f);
+	free(r.buf);
+	free(r.tok);
+	free(r.selected);
+	ligolw_table_filter_free(r.prog);
+	return r.table;
+}
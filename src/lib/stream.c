@@ -16,10 +16,14 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  */
 
-#include <assert.h>
-#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <b64/cdecode.h>
 #include <./stream.h>
 #include <ezligolw/ezligolw.h>
 
@@ -169,107 +173,443 @@ enum ligolw_stream_encoding ligolw_stream_check_encoding(ezxml_t stream)
 
 /*
  * Identify the start and end of the next delimited token in an XML Stream
- * element.  Shared by Table and Array parsing.
+ * element.  Shared by Table and Array parsing.  txt points to the current
+ * position in the Stream's text, which ends at end;  the text need not be
+ * null-terminated, and is not modified.  On return start and stop bracket
+ * the token (the quote characters of a quoted token are excluded), and txt
+ * has been advanced past the delimiter that follows it.  Returns the
+ * number of escape sequences in the token, which is 0 if the characters
+ * between start and stop can be used as they are, or < 0 if the text is
+ * malformed.
  */
 
 
-void ligolw_stream_next_token(char **txt, char **start, char **end, char delimiter)
+int ligolw_stream_next_token(const char **txt, const char *end, const char **start, const char **stop, char delimiter)
 {
-	char *c;
+	const char *c;
+	int escapes = 0;
 
 	/* find the token's start, the first non-white space character */
-	for(c = *txt; isspace(*c); c++);
+	for(c = *txt; c < end && isspace(*c); c++);
 
-	if(*c == QUOTE_CHAR) {
+	if(c < end && *c == QUOTE_CHAR) {
 		/* quoted token */
 
-		/* start is first character after quote charater.  below,
-		 * end will be left pointing to the first character after
-		 * the token, either the terminating quote character or the
-		 * null terminator */
+		/* start is first character after quote charater, stop
+		 * will be left pointing to the terminating quote
+		 * character */
 
 		*start = ++c;
 
-		/* find the first escape sequence, an unescaped quote
-		 * character, or the null terminator */
-		for(; *c && *c != ESCAPE_CHAR && *c != QUOTE_CHAR; c++);
-
-		if(*c == QUOTE_CHAR) {
-			/* no escaped characters encountered.  record the
-			 * end position */
-			*end = c;
-			/* advance over the quote character */
-			c++;
-		} else if(*c == ESCAPE_CHAR) {
-			/* this quoted token contains escaped special
-			 * characters.  process the remainder of the token
-			 * using escape handling logic */
-
-			char *j = c;
-
-			goto start;
-			for(; *j && *j != QUOTE_CHAR; *(c++) = *(j++)) {
-				/*
-				 * is this character the escape character?
-				 */
-
-				if(*j != ESCAPE_CHAR)
-					continue;
-
-start:
-				/*
-				 * check for an unrecognized escape
-				 * sequence, or an escape sequence starting
-				 * in the last character position.
-				 */
-
-				if(!*(++j)) {
-					/* FIXME:  report incomplete escape
-					 * sequence at end of string error */
-					assert(false);
-				} else if(*j != ESCAPE_CHAR && *j != QUOTE_CHAR) {
-					/* FIXME:  report unrecognized escape
-					 * sequence error */
-					assert(false);
-				}
+		/* find the terminating quote character, counting escape
+		 * sequences along the way */
+		for(; c < end && *c != QUOTE_CHAR; c++) {
+			if(*c != ESCAPE_CHAR)
+				continue;
+			if(++c >= end) {
+				/* incomplete escape sequence at end of
+				 * string */
+				return -1;
+			} else if(*c != ESCAPE_CHAR && *c != QUOTE_CHAR) {
+				/* unrecognized escape sequence */
+				return -1;
 			}
-			/* move the final character, the one that
-			 * terminated the token */
-			*c = *j;
-
-			/* record the end position */
-			*end = c;
-
-			/* continue processing from the original position
-			 * of the token's end */
-			c = j;
-		} else {
-			/* hit null terminator without finding closing
+			escapes++;
+		}
+
+		if(c >= end) {
+			/* hit the end of the text without finding closing
 			 * quote character */
-			/* FIXME:  report unterminatd quoted string */
-			assert(false);
+			return -1;
 		}
+
+		/* record the end position and advance over the quote
+		 * character */
+		*stop = c++;
 	} else {
 		/* unquoted token */
 		/* start at first non-white space character */
 		*start = c;
-		/* end at space or delimiter or '\0' */
-		for(; *c && !isspace(*c) && *c != delimiter; c++);
-		*end = c;
+		/* stop at space or delimiter or end of text */
+		for(; c < end && !isspace(*c) && *c != delimiter; c++);
+		*stop = c;
 	}
 
 	/* advance to what should be the delimiter marking the
 	 * boundary between this and the next tokens */
-	for(; isspace(*c) && *c != delimiter; c++);
+	for(; c < end && isspace(*c) && *c != delimiter; c++);
 
 	/* next token processing starts after delimiter */
-	if(*c == delimiter)
+	if(c >= end)
+		*txt = end;
+	else if(*c == delimiter)
 		*txt = c + 1;
-	else if(!*c)
-		*txt = c;
 	else {
-		/* FIXME:  expected white space or delimiter following
-		 * token, found something else */
-		assert(false);
+		/* expected white space or delimiter following token,
+		 * found something else */
+		return -1;
+	}
+
+	return escapes;
+}
+
+
+/*
+ * Structural index of a Stream's text.  The text is examined 64 bytes at a
+ * time, and for each 64 byte block a bit mask is recorded of which bytes
+ * are white space, which are the delimiter, and which are quote or escape
+ * characters.  Tokens are then found by scanning the masks for set bits
+ * instead of testing the text one character at a time.  The masks are
+ * computed for a window of LIGOLW_STREAM_INDEX_BLOCKS blocks at a time, so
+ * the index is small enough to stay in cache and the text is read from
+ * memory once while the window is built.
+ */
+
+
+#define LIGOLW_STREAM_INDEX_BLOCKS 1024
+
+
+struct ligolw_stream_index {
+	const char *end;
+	char delimiter;
+	/* the window, the text from base to wend, is indexed */
+	const char *base;
+	const char *wend;
+	/* bit i of block b describes the character base[64 * b + i] */
+	uint64_t space[LIGOLW_STREAM_INDEX_BLOCKS];
+	uint64_t delim[LIGOLW_STREAM_INDEX_BLOCKS];
+	uint64_t special[LIGOLW_STREAM_INDEX_BLOCKS];
+};
+
+
+/* what to search for */
+enum stream_index_find {
+	FIND_NON_SPACE,
+	FIND_SPACE_OR_DELIMITER,
+	FIND_QUOTE_OR_ESCAPE,
+	/* anything but white space that is not the delimiter */
+	FIND_NON_PADDING
+};
+
+
+/*
+ * Compute the masks for the n <= 64 characters starting at s.
+ */
+
+
+static void stream_index_block(struct ligolw_stream_index *index, int b, const char *s, size_t n)
+{
+	uint64_t space = 0, delim = 0, special = 0;
+	size_t i = 0;
+
+#ifdef __SSE2__
+	const __m128i blank = _mm_set1_epi8(' ');
+	const __m128i tab = _mm_set1_epi8('\t');
+	const __m128i four = _mm_set1_epi8(4);
+	const __m128i delimiter = _mm_set1_epi8(index->delimiter);
+	const __m128i quote = _mm_set1_epi8(QUOTE_CHAR);
+	const __m128i escape = _mm_set1_epi8(ESCAPE_CHAR);
+
+	for(; i + 16 <= n; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *) (s + i));
+		/* '\t', '\n', '\v', '\f' and '\r' are 9 through 13 */
+		__m128i t = _mm_sub_epi8(v, tab);
+		__m128i w = _mm_or_si128(_mm_cmpeq_epi8(v, blank), _mm_cmpeq_epi8(_mm_min_epu8(t, four), t));
+		space |= (uint64_t) (uint16_t) _mm_movemask_epi8(w) << i;
+		delim |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, delimiter)) << i;
+		special |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, escape))) << i;
+	}
+#endif
+
+	for(; i < n; i++) {
+		if(isspace((unsigned char) s[i]))
+			space |= (uint64_t) 1 << i;
+		if(s[i] == index->delimiter)
+			delim |= (uint64_t) 1 << i;
+		if(s[i] == QUOTE_CHAR || s[i] == ESCAPE_CHAR)
+			special |= (uint64_t) 1 << i;
+	}
+
+	index->space[b] = space;
+	index->delim[b] = delim;
+	index->special[b] = special;
+}
+
+
+/*
+ * Index the window of text starting at txt.
+ */
+
+
+static void stream_index_fill(struct ligolw_stream_index *index, const char *txt)
+{
+	size_t n = index->end - txt;
+	size_t i;
+	int b;
+
+	if(n > 64 * LIGOLW_STREAM_INDEX_BLOCKS)
+		n = 64 * LIGOLW_STREAM_INDEX_BLOCKS;
+	index->base = txt;
+	index->wend = txt + n;
+
+	for(b = 0, i = 0; i < n; b++, i += 64)
+		stream_index_block(index, b, txt + i, n - i < 64 ? n - i : 64);
+}
+
+
+/*
+ * Index of the lowest set bit of m, which must not be 0.
+ */
+
+
+static inline int stream_index_ctz(uint64_t m)
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll(m);
+#else
+	int n = 0;
+	for(; !(m & 1); m >>= 1)
+		n++;
+	return n;
+#endif
+}
+
+
+static inline uint64_t stream_index_mask(const struct ligolw_stream_index *index, size_t b, enum stream_index_find what)
+{
+	switch(what) {
+	case FIND_NON_SPACE:
+		return ~index->space[b];
+	case FIND_SPACE_OR_DELIMITER:
+		return index->space[b] | index->delim[b];
+	case FIND_QUOTE_OR_ESCAPE:
+		return index->special[b];
+	default:
+		return ~(index->space[b] & ~index->delim[b]);
+	}
+}
+
+
+/*
+ * Return the address of the first character at or after c that is of the
+ * kind sought, or the end of the text if there is none.  Bits for
+ * positions past the end of the window in its final block are not
+ * meaningful, so a match found there is treated as no match and the
+ * search continues in the next window.
+ */
+
+
+static inline const char *stream_index_find(struct ligolw_stream_index *index, const char *c, enum stream_index_find what)
+{
+	while(c < index->end) {
+		size_t i, b, n_blocks;
+		uint64_t m;
+
+		if(c < index->base || c >= index->wend)
+			stream_index_fill(index, c);
+		i = c - index->base;
+		n_blocks = (index->wend - index->base + 63) / 64;
+
+		/* ignore the characters in c's block that precede it */
+		b = i / 64;
+		m = stream_index_mask(index, b, what) & (~(uint64_t) 0 << (i % 64));
+		while(!m && ++b < n_blocks)
+			m = stream_index_mask(index, b, what);
+		if(m) {
+			c = index->base + b * 64 + stream_index_ctz(m);
+			if(c < index->wend)
+				return c;
+		}
+
+		/* not in this window, continue in the next */
+		c = index->wend;
+	}
+
+	return index->end;
+}
+
+
+/*
+ * Create a structural index for the Stream text from txt to end, which
+ * need not be null-terminated.  Returns NULL on failure.  Free with
+ * ligolw_stream_index_free().
+ */
+
+
+struct ligolw_stream_index *ligolw_stream_index_new(const char *txt, const char *end, char delimiter)
+{
+	struct ligolw_stream_index *index = malloc(sizeof(*index));
+
+	if(!index)
+		return NULL;
+	index->end = end;
+	index->delimiter = delimiter;
+	/* nothing is indexed until the first search */
+	index->base = index->wend = txt;
+
+	return index;
+}
+
+
+void ligolw_stream_index_free(struct ligolw_stream_index *index)
+{
+	free(index);
+}
+
+
+/*
+ * Equivalent to ligolw_stream_next_token() for the text covered by the
+ * index, but finds the token's boundaries from the index.  txt must point
+ * into the indexed text.
+ */
+
+
+int ligolw_stream_index_next_token(struct ligolw_stream_index *index, const char **txt, const char **start, const char **stop)
+{
+	const char *end = index->end;
+	const char *c;
+	int escapes = 0;
+
+	/* find the token's start, the first non-white space character.
+	 * usually there is none to skip */
+	c = *txt;
+	if(c < end && isspace((unsigned char) *c))
+		c = stream_index_find(index, c, FIND_NON_SPACE);
+
+	if(c < end && *c == QUOTE_CHAR) {
+		/* quoted token */
+		*start = ++c;
+
+		/* find the terminating quote character, counting escape
+		 * sequences along the way */
+		while((c = stream_index_find(index, c, FIND_QUOTE_OR_ESCAPE)) < end && *c != QUOTE_CHAR) {
+			if(++c >= end) {
+				/* incomplete escape sequence at end of
+				 * string */
+				return -1;
+			} else if(*c != ESCAPE_CHAR && *c != QUOTE_CHAR) {
+				/* unrecognized escape sequence */
+				return -1;
+			}
+			escapes++;
+			c++;
+		}
+
+		if(c >= end) {
+			/* hit the end of the text without finding closing
+			 * quote character */
+			return -1;
+		}
+
+		*stop = c++;
+	} else {
+		/* unquoted token, stops at space or delimiter or end of
+		 * text */
+		*start = c;
+		*stop = c = stream_index_find(index, c, FIND_SPACE_OR_DELIMITER);
+	}
+
+	/* advance to what should be the delimiter marking the
+	 * boundary between this and the next tokens.  usually c is
+	 * already there */
+	if(c < end && *c != index->delimiter)
+		c = stream_index_find(index, c, FIND_NON_PADDING);
+
+	/* next token processing starts after delimiter */
+	if(c >= end)
+		*txt = end;
+	else if(*c == index->delimiter)
+		*txt = c + 1;
+	else {
+		/* expected white space or delimiter following token,
+		 * found something else */
+		return -1;
+	}
+
+	return escapes;
+}
+
+
+/*
+ * Convert a token identified by ligolw_stream_next_token() to a union
+ * ligolw_cell of the given type.  escapes is the value returned by
+ * ligolw_stream_next_token().  If the token contains escape sequences they
+ * are removed from a copy, the document's text is not modified.  Returns
+ * the address of the union ligolw_cell object on success, NULL on error.
+ */
+
+
+union ligolw_cell *ligolw_stream_token_to_cell(union ligolw_cell *cell, enum ligolw_cell_type type, const char *start, const char *stop, int escapes)
+{
+	char *txt, *c;
+
+	if(!escapes)
+		return ligolw_cell_from_txtn(cell, type, start, stop - start);
+
+	txt = c = malloc(stop - start - escapes + 1);
+	if(!txt)
+		return NULL;
+	for(; start < stop; *c++ = *start++)
+		if(*start == ESCAPE_CHAR)
+			start++;
+	*c = '\0';
+
+	cell = ligolw_cell_from_txt(cell, type, txt);
+	free(txt);
+
+	return cell;
+}
+
+
+/*
+ * Same as ligolw_stream_token_to_cell() but string and blob values are
+ * decoded into buf, which must have room for stop - start + 1 bytes,
+ * instead of into newly allocated memory, and the escape sequences of
+ * other tokens are removed there instead of in a copy.  The cell then
+ * points into buf, and must not be free()ed.  Used to decode rows with
+ * LIGOLW_TABLE_REUSE_ROW.
+ */
+
+
+union ligolw_cell *ligolw_stream_token_to_cell_buf(union ligolw_cell *cell, enum ligolw_cell_type type, const char *start, const char *stop, int escapes, char *buf)
+{
+	char *c = buf;
+	size_t len;
+
+	if(escapes) {
+		for(; start < stop; *c++ = *start++)
+			if(*start == ESCAPE_CHAR)
+				start++;
+		start = buf;
+		stop = c;
+	}
+	len = stop - start;
+
+	switch(type) {
+	case ligolw_cell_type_char_s:
+	case ligolw_cell_type_char_v:
+	case ligolw_cell_type_ilwdchar:
+	case ligolw_cell_type_ilwdchar_u:
+	case ligolw_cell_type_lstring:
+		if(!escapes)
+			memcpy(buf, start, len);
+		buf[len] = '\0';
+		cell->as_string = buf;
+		return cell;
+
+	case ligolw_cell_type_blob: {
+		/* the decoded data is never longer than the text, and
+		 * decoding text already in buf in place is safe because
+		 * the decoder never writes ahead of where it reads */
+		base64_decodestate b64state;
+		base64_init_decodestate(&b64state);
+		cell->as_blob.len = len; /*FIXME: see ligolw_cell_from_txtn() */
+		cell->as_blob.data = buf;
+		base64_decode_block(start, len, buf, &b64state);
+		return cell;
+	}
+
+	default:
+		return ligolw_cell_from_txtn(cell, type, start, len);
 	}
 }
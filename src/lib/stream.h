@@ -34,6 +34,21 @@ enum ligolw_stream_encoding {
 	ligolw_stream_enc_b64le		= 0x28  /* base64 little endian */
 };
 
+/* a token found by ligolw_stream_next_token() */
+struct ligolw_stream_token {
+	const char *start;
+	const char *stop;
+	int escapes;
+};
+
+/* structural index of a Stream's text, see stream.c */
+struct ligolw_stream_index;
+
 char ligolw_stream_delimiter(ezxml_t);
 enum ligolw_stream_encoding ligolw_stream_check_encoding(ezxml_t stream);
-void ligolw_stream_next_token(char **, char **, char **, char);
+int ligolw_stream_next_token(const char **, const char *, const char **, const char **, char);
+struct ligolw_stream_index *ligolw_stream_index_new(const char *, const char *, char);
+void ligolw_stream_index_free(struct ligolw_stream_index *);
+int ligolw_stream_index_next_token(struct ligolw_stream_index *, const char **, const char **, const char **);
+union ligolw_cell *ligolw_stream_token_to_cell(union ligolw_cell *, enum ligolw_cell_type, const char *, const char *, int);
+union ligolw_cell *ligolw_stream_token_to_cell_buf(union ligolw_cell *, enum ligolw_cell_type, const char *, const char *, int, char *);
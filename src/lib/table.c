@@ -19,14 +19,52 @@
 
 #include <assert.h>
 #include <complex.h>
+#include <ctype.h>
+#include <limits.h>
+#include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <./stream.h>
+#include <./table.h>
 #include <ezligolw/ezligolw.h>
 
 
+/* default number of rows passed to ligolw_table_parse_batches()'s
+ * call-back at a time */
+#ifndef LIGOLW_TABLE_BATCH_SIZE
+#define LIGOLW_TABLE_BATCH_SIZE 1024
+#endif
+
+
+/* number of rows for which space is first allocated by the default row
+ * builder */
+#define LIGOLW_TABLE_MIN_ROWS 64
+
+
+/* the most by which the default row builder multiplies the room for rows
+ * when the rows decoded so far suggest the table is larger */
+#define LIGOLW_TABLE_MAX_GROWTH 8
+
+
+/* ligolw_table_parse_parallel() does not split the Stream into pieces
+ * smaller than this many bytes, nor into more than this many pieces per
+ * thread */
+#ifndef LIGOLW_TABLE_MIN_CHUNK
+#define LIGOLW_TABLE_MIN_CHUNK (1 << 20)
+#endif
+#define LIGOLW_TABLE_CHUNKS_PER_THREAD 4
+
+
+/* size of the blocks of a table's arena */
+#ifndef LIGOLW_TABLE_ARENA_BLOCK
+#define LIGOLW_TABLE_ARENA_BLOCK (1 << 20)
+#endif
+
+
 /*
  * Extract the meaningful portion of a table name.  Returns a pointer to
  * the last colon-delimited substring before an optional ":table" suffix.
@@ -40,208 +78,1651 @@ static const char *ligolw_strip_table_name(const char *Name)
 
 
 /*
- * Extract the meaningful portion of a column name.  Returns a pointer to
- * the last colon-delimited substring.
+ * Extract the meaningful portion of a column name.  Returns a pointer to
+ * the last colon-delimited substring.
+ */
+
+
+static const char *ligolw_strip_column_name(const char *Name)
+{
+	return ligolw_strip_name(Name, NULL);
+}
+
+
+/*
+ * The number of rows to make room for when a table's rows array is full,
+ * or < 0 if that many can't be counted with an int.
+ */
+
+
+static int table_next_capacity(const struct ligolw_table *table)
+{
+	if(!table->rows_capacity)
+		return LIGOLW_TABLE_MIN_ROWS;
+	if(table->rows_capacity > INT_MAX / 2)
+		return -1;
+	return 2 * table->rows_capacity;
+}
+
+
+/*
+ * Default row builder call-back.  Appends the contents of the row object
+ * to the rows array in table, which grows geometrically.
+ */
+
+
+int ligolw_table_default_row_callback(struct ligolw_table *table, struct ligolw_table_row *row, void *ignored)
+{
+	if(table->n_rows == table->rows_capacity) {
+		int n = table_next_capacity(table);
+		struct ligolw_table_row *rows = n < 0 ? NULL : realloc(table->rows, n * sizeof(*rows));
+		if(!rows) {
+			ligolw_table_free_row(table, row);
+			return -1;
+		}
+		table->rows = rows;
+		table->rows_capacity = n;
+	}
+	table->rows[table->n_rows] = *row;
+	table->n_rows++;
+	free(row);
+	return 0;
+}
+
+
+/*
+ * Return the address of the ligolw_cell corresponding to the named column
+ * If type is not NULL, the cell type is stored in the location it points
+ * to.  Returns NULL on error;
+ */
+
+
+union ligolw_cell *ligolw_row_get_cell(const struct ligolw_table_row *row, const char *name, enum ligolw_cell_type *type)
+{
+	int i = ligolw_table_get_column(row->table, name, type);
+	return i >= 0 ? &row->cells[i] : NULL;
+}
+
+
+/*
+ * Hash a column name for the table's column index (FNV-1a).
+ */
+
+
+static unsigned ligolw_column_name_hash(const char *name)
+{
+	unsigned hash = 2166136261u;
+
+	for(; *name; name++)
+		hash = (hash ^ (unsigned char) *name) * 16777619u;
+
+	return hash;
+}
+
+
+/*
+ * Build the table's column index, an open-addressing hash table of the
+ * columns' indexes, so that ligolw_table_get_column() takes the same time
+ * however many columns the table has.  If two columns have the same name
+ * only the first is indexed, which is the one a search of the columns
+ * array would find.  Failure to allocate memory leaves the index NULL,
+ * and columns are then found by searching the columns array.
+ */
+
+
+static void ligolw_table_index_columns(struct ligolw_table *table)
+{
+	unsigned size = 8;
+	unsigned i;
+	int c;
+
+	while(size < 2 * (unsigned) table->n_columns)
+		size *= 2;
+	table->column_index = malloc(size * sizeof(*table->column_index));
+	if(!table->column_index)
+		return;
+	table->column_index_mask = size - 1;
+	for(i = 0; i < size; i++)
+		table->column_index[i] = -1;
+
+	for(c = 0; c < table->n_columns; c++) {
+		const char *name = table->columns[c].name;
+		if(!name)
+			continue;
+		for(i = ligolw_column_name_hash(name) & table->column_index_mask; table->column_index[i] >= 0; i = (i + 1) & table->column_index_mask)
+			if(!strcmp(table->columns[table->column_index[i]].name, name))
+				/* duplicate */
+				break;
+		if(table->column_index[i] < 0)
+			table->column_index[i] = c;
+	}
+}
+
+
+/*
+ * Allocate a new struct ligolw_table and populate its metadata from an
+ * ezxml_t Table element:  the table's name, its columns, and, if the
+ * Table has a Stream child, the Stream's delimiter.  The rows array is
+ * left empty.  Shared by ligolw_table_parse() and the file reader.
+ * Returns NULL on failure, including if the Stream's delimiter or encoding
+ * is invalid or not supported.
+ */
+
+
+struct ligolw_table *ligolw_table_new(ezxml_t elem)
+{
+	struct ligolw_table *table;
+	ezxml_t column;
+	ezxml_t stream;
+
+	table = malloc(sizeof(*table));
+	if(!table)
+		return NULL;
+
+	table->name = ligolw_strip_table_name(ezxml_attr(elem, "Name"));
+
+	table->delimiter = '\0';
+	table->n_columns = 0;
+	table->columns = NULL;
+	table->n_rows = 0;
+	table->rows = NULL;
+	table->header = NULL;
+	table->column_index = NULL;
+	table->column_index_mask = 0;
+	table->rows_capacity = 0;
+	table->cells = NULL;
+	table->plan = NULL;
+	table->reused_row = NULL;
+	table->arena = NULL;
+	table->borrowed_strings = 0;
+
+	/* the table can now be free()ed with ligolw_table_free() */
+
+	for(column = ezxml_child(elem, "Column"); column; column = column->next) {
+		table->columns = realloc(table->columns, (table->n_columns + 1) * sizeof(*table->columns));
+
+		table->columns[table->n_columns].name = ligolw_strip_column_name(ezxml_attr(column, "Name"));
+		table->columns[table->n_columns].table = table;
+		table->columns[table->n_columns].type = ligolw_type_name_to_enum(ezxml_attr(column, "Type"));
+
+		table->n_columns++;
+	}
+	ligolw_table_index_columns(table);
+
+	stream = ezxml_child(elem, "Stream");
+	if(!stream) {
+		/* DTD allows Table to have 0 Stream children */
+		return table;
+	}
+
+	table->delimiter = ligolw_stream_delimiter(stream);
+	if(table->delimiter < 0) {
+		ligolw_table_free(table);
+		return NULL;
+	}
+
+	if(ligolw_stream_check_encoding(stream) != ligolw_stream_enc_text) {
+		ligolw_table_free(table);
+		return NULL;
+	}
+
+	return table;
+}
+
+
+/*
+ * Report which of a table's columns are to be converted, according to the
+ * options passed to ligolw_table_parse_opts().  Returns a newly allocated
+ * array of n_columns flags, which the calling code must free(), or NULL
+ * if all columns are to be converted.  On failure, *failed is set to true
+ * and NULL is returned.  Names in the options that are not the names of
+ * columns in the table are ignored.
+ */
+
+
+bool *ligolw_table_selected_columns(const struct ligolw_table *table, const struct ligolw_table_options *options, bool *failed)
+{
+	const char *const *name;
+	bool *selected;
+
+	*failed = false;
+	if(!options || !options->columns)
+		return NULL;
+
+	selected = calloc(table->n_columns + 1, sizeof(*selected));
+	if(!selected) {
+		*failed = true;
+		return NULL;
+	}
+	for(name = options->columns; *name; name++) {
+		int c = ligolw_table_get_column((struct ligolw_table *) table, *name, NULL);
+		if(c >= 0)
+			selected[c] = true;
+	}
+
+	return selected;
+}
+
+
+/*
+ * Parse an ezxml_t Table element into a struct ligolw_table structure.  If
+ * row_callback() is NULL, then the default row builder is used, which
+ * inserts the rows directly into the ligolw_table structure.  Calling code
+ * can provide it's own function, which will be called after each row is
+ * constructed.  This allows the data contained in each row to be
+ * redirected, for example to store it in an application-specific type, or
+ * process it on-the-fly to produce some kind of output directly.  The
+ * call-back function will be passed the address of the current struct
+ * ligolw_table as its first argument, the address of a newly allocated
+ * struct ligolw_table_row as its second, and the callback_data pointer as
+ * its third argument.  The row_callback() function takes ownership of the
+ * row structure and the data contained within it, and is responsible for
+ * freeing all memory associated with the object when it no longer requires
+ * it.  All allocated cell data can be freed with
+ * ligolw_table_free_row_data(), and the struct ligolw_table_row freed with
+ * free().  The call-back returns 0 to indicate success, non-zero to
+ * indicate failure.
+ *
+ * If the Table element is empty, the row_callback() function will not be
+ * called.
+ *
+ * When row_callback() is NULL, the string and blob data of the rows are
+ * allocated from an arena owned by the table, and freed all at once by
+ * ligolw_table_free().  The cells' data must not be free()ed or taken by
+ * the calling code, so ligolw_cell_to_c() and ligolw_cell_string_copy()
+ * must not be used on the table's rows.  Earlier versions allocated each
+ * value separately;  to get that behaviour, which allows the values to be
+ * taken, call ligolw_table_parse_opts() with LIGOLW_TABLE_OWN_STRINGS.
+ *
+ * ligolw_table_parse() returns the pointer to the new struct ligolw_table
+ * structure on success, NULL on failure.
+ */
+
+
+struct ligolw_table *ligolw_table_parse(ezxml_t elem, int (row_callback)(struct ligolw_table *, struct ligolw_table_row *, void *), void *callback_data)
+{
+	return ligolw_table_parse_opts(elem, NULL, row_callback, callback_data);
+}
+
+
+/*
+ * Find the tokens of the next row of a table's Stream.  index is the
+ * structural index of the Stream's text, and txt points to the current
+ * position in it and is advanced past the row.  tokens must have room for
+ * one token per column.  Returns < 0 if the Stream is malformed.  Like
+ * ligolw_table_parse(), an incomplete final row is padded with empty
+ * tokens.
+ */
+
+
+int ligolw_table_next_row(const struct ligolw_table *table, struct ligolw_stream_index *index, const char **txt, struct ligolw_stream_token *tokens)
+{
+	int c;
+
+	if(!table->n_columns)
+		/* a Stream with text but no columns to put it in */
+		return -1;
+
+	for(c = 0; c < table->n_columns; c++) {
+		tokens[c].escapes = ligolw_stream_index_next_token(index, txt, &tokens[c].start, &tokens[c].stop);
+		if(tokens[c].escapes < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+
+/*
+ * A block of a table's arena.  The string and blob data of the rows built
+ * by the default row builder is allocated from the block at the head of
+ * the list until it is full, and is freed with the blocks instead of cell
+ * by cell.
+ */
+
+
+/* a type with the alignment required for any type a blob's data might be
+ * converted to (C99 has no max_align_t) */
+union table_arena_align {
+	long double ld;
+	long long ll;
+	double d;
+	void *p;
+};
+
+
+struct ligolw_table_arena {
+	/* the previously allocated block */
+	struct ligolw_table_arena *next;
+	size_t size;
+	size_t used;
+	union table_arena_align data[];
+};
+
+
+/*
+ * Allocate n bytes from the arena whose head is *arena, adding a block if
+ * needed.  Blobs are given memory aligned for any type, strings are not
+ * aligned.  Returns NULL on failure.
+ */
+
+
+static void *table_arena_alloc(struct ligolw_table_arena **arena, size_t n, bool aligned)
+{
+	struct ligolw_table_arena *block = *arena;
+	size_t offset;
+
+	if(block) {
+		offset = block->used;
+		if(aligned)
+			offset = (offset + sizeof(union table_arena_align) - 1) / sizeof(union table_arena_align) * sizeof(union table_arena_align);
+		if(offset + n <= block->size) {
+			block->used = offset + n;
+			return (char *) block->data + offset;
+		}
+	}
+
+	block = malloc(sizeof(*block) + (n > LIGOLW_TABLE_ARENA_BLOCK ? n : LIGOLW_TABLE_ARENA_BLOCK));
+	if(!block)
+		return NULL;
+	block->size = n > LIGOLW_TABLE_ARENA_BLOCK ? n : LIGOLW_TABLE_ARENA_BLOCK;
+	block->used = n;
+	if(*arena && n > LIGOLW_TABLE_ARENA_BLOCK) {
+		/* a large value gets a block of its own, the head keeps
+		 * its free space */
+		block->next = (*arena)->next;
+		(*arena)->next = block;
+	} else {
+		block->next = *arena;
+		*arena = block;
+	}
+	return block->data;
+}
+
+
+/*
+ * Free all of an arena's blocks.
+ */
+
+
+static void table_arena_free(struct ligolw_table_arena *arena)
+{
+	while(arena) {
+		struct ligolw_table_arena *next = arena->next;
+		free(arena);
+		arena = next;
+	}
+}
+
+
+/*
+ * Append the blocks of the arena src to the arena whose head is *dst.
+ */
+
+
+static void table_arena_splice(struct ligolw_table_arena **dst, struct ligolw_table_arena *src)
+{
+	struct ligolw_table_arena *tail = src;
+
+	if(!src)
+		return;
+	while(tail->next)
+		tail = tail->next;
+	tail->next = *dst;
+	*dst = src;
+}
+
+
+/*
+ * State shared by the functions that decode a Table element's Stream into
+ * rows of cells.
+ */
+
+
+struct table_parser {
+	struct ligolw_table *table;
+	/* the Stream's text still to be parsed */
+	const char *txt;
+	const char *end;
+	/* rows that start at or after stop are left for another parser */
+	const char *stop;
+	struct ligolw_stream_index *index;
+	/* columns to convert, NULL for all, and the compiled filter */
+	bool *selected;
+	struct ligolw_table_filter_prog *prog;
+	/* the current row's tokens */
+	struct ligolw_stream_token *tokens;
+	/* if not NULL, string and blob values are decoded into this
+	 * buffer, which is re-used for each row, instead of into newly
+	 * allocated memory */
+	char *scratch;
+	size_t scratch_size;
+	/* if not NULL, string and blob values are decoded into memory
+	 * allocated from the arena whose head this points to, instead of
+	 * into memory allocated for each */
+	struct ligolw_table_arena **arena;
+	/* if true, unescaped string values are left in the Stream's text,
+	 * which must be writable, and terminated there.  see
+	 * LIGOLW_TABLE_BORROW_STRINGS */
+	bool borrow;
+};
+
+
+/*
+ * Construct the table from the Table element, and prepare to decode its
+ * Stream.  Returns < 0 on failure.
+ */
+
+
+static int table_parser_init(struct table_parser *p, ezxml_t elem, const struct ligolw_table_options *options)
+{
+	ezxml_t stream;
+	bool failed;
+
+	memset(p, 0, sizeof(*p));
+
+	p->table = ligolw_table_new(elem);
+	if(!p->table)
+		return -1;
+
+	stream = ezxml_child(elem, "Stream");
+	if(!stream) {
+		/* DTD allows Table to have 0 Stream children */
+		return 0;
+	}
+
+	/* a lazily parsed document decodes the Stream on first use */
+	p->txt = ezxml_txt_decode(stream);
+	if(!p->txt)
+		return -1;
+	p->end = p->stop = p->txt + ezxml_txt_len(stream);
+	p->index = ligolw_stream_index_new(p->txt, p->end, p->table->delimiter);
+	if(!p->index)
+		return -1;
+	p->selected = ligolw_table_selected_columns(p->table, options, &failed);
+	if(failed)
+		return -1;
+	if(options && options->filter) {
+		p->prog = ligolw_table_filter_compile(p->table, options->filter);
+		if(!p->prog)
+			return -1;
+	}
+	p->tokens = malloc((p->table->n_columns + 1) * sizeof(*p->tokens));
+	if(!p->tokens)
+		return -1;
+
+	return 0;
+}
+
+
+/*
+ * Free the parser's state, but not the table.
+ */
+
+
+static void table_parser_free(struct table_parser *p)
+{
+	ligolw_stream_index_free(p->index);
+	free(p->tokens);
+	free(p->scratch);
+	free(p->selected);
+	ligolw_table_filter_free(p->prog);
+}
+
+
+/*
+ * Convert the token of column c to its cell.  If the parser has a scratch
+ * buffer *buf is the next free byte in it, and is advanced past the
+ * token's value.  Returns < 0 if the token is not a valid value of the
+ * column's type, or if memory cannot be allocated.
+ */
+
+
+static int table_parser_convert(struct table_parser *p, union ligolw_cell *cells, int c, char **buf)
+{
+	const struct ligolw_stream_token *token = &p->tokens[c];
+	enum ligolw_cell_type type = p->table->columns[c].type;
+
+	if(p->borrow && !token->escapes) {
+		switch(type) {
+		case ligolw_cell_type_char_s:
+		case ligolw_cell_type_char_v:
+		case ligolw_cell_type_ilwdchar:
+		case ligolw_cell_type_ilwdchar_u:
+		case ligolw_cell_type_lstring: {
+			/* the row's tokens have all been found, so the
+			 * closing quote or delimiter at stop is no longer
+			 * needed.  at the end of the text stop is the
+			 * terminator, which might not be writable */
+			char *stop = (char *) token->stop;
+			if(*stop)
+				*stop = '\0';
+			cells[c].as_string = (char *) token->start;
+			return 0;
+		}
+
+		default:
+			break;
+		}
+	}
+	if(p->scratch) {
+		union ligolw_cell *cell = ligolw_stream_token_to_cell_buf(&cells[c], type, token->start, token->stop, token->escapes, *buf);
+		*buf += token->stop - token->start + 1;
+		return cell ? 0 : -1;
+	}
+	if(p->arena) {
+		char *dst;
+		switch(type) {
+		case ligolw_cell_type_char_s:
+		case ligolw_cell_type_char_v:
+		case ligolw_cell_type_ilwdchar:
+		case ligolw_cell_type_ilwdchar_u:
+		case ligolw_cell_type_lstring:
+		case ligolw_cell_type_blob:
+			dst = table_arena_alloc(p->arena, token->stop - token->start + 1, type == ligolw_cell_type_blob);
+			if(!dst)
+				return -1;
+			return ligolw_stream_token_to_cell_buf(&cells[c], type, token->start, token->stop, token->escapes, dst) ? 0 : -1;
+
+		default:
+			break;
+		}
+	}
+	return ligolw_stream_token_to_cell(&cells[c], type, token->start, token->stop, token->escapes) ? 0 : -1;
+}
+
+
+/*
+ * Decode the next row that passes the filter into cells, which must be
+ * zeroed.  Returns 1 if a row was decoded, 0 at the end of the Stream, or
+ * < 0 if the Stream is malformed, contains an invalid value, or memory
+ * cannot be allocated.  Unless the parser has a scratch buffer or an
+ * arena, the cells must be cleared with ligolw_table_free_cells() in that
+ * case.  With a scratch buffer, string and blob cells point into it and
+ * are valid until the next call.  With an arena they point into it.
+ */
+
+
+static int table_parser_next(struct table_parser *p, union ligolw_cell *cells)
+{
+	struct ligolw_table *table = p->table;
+	struct ligolw_stream_token *tokens = p->tokens;
+	char *buf;
+	int c;
+
+	while(p->txt < p->stop) {
+		if(ligolw_table_next_row(table, p->index, &p->txt, tokens) < 0) {
+			/* malformed Stream */
+			return -1;
+		}
+
+		/* the document's text is not modified.  if the token is a
+		 * string or blob type, a decoded copy gets made, either in
+		 * the scratch buffer or in newly allocated memory that we
+		 * own and need to free() when finished */
+
+		if(p->scratch) {
+			/* make room for every token so that the buffer
+			 * can't move while the row's cells point into it */
+			size_t size = 0;
+			for(c = 0; c < table->n_columns; c++)
+				size += tokens[c].stop - tokens[c].start + 1;
+			if(size > p->scratch_size) {
+				while(p->scratch_size < size)
+					p->scratch_size *= 2;
+				free(p->scratch);
+				p->scratch = malloc(p->scratch_size);
+				if(!p->scratch)
+					return -1;
+			}
+		}
+		buf = p->scratch;
+
+		if(p->prog) {
+			/* where the arena's free space began, so that the
+			 * data of a rejected row can be given back */
+			struct ligolw_table_arena *block = p->arena ? *p->arena : NULL;
+			size_t used = block ? block->used : 0;
+			for(c = 0; c < table->n_columns; c++)
+				if(p->prog->columns[c] && table_parser_convert(p, cells, c, &buf) < 0)
+					return -1;
+			if(!ligolw_table_filter_eval(p->prog, cells)) {
+				/* rejected.  only the filter's columns
+				 * were converted, clear them and move on
+				 * to the next row */
+				if(p->arena) {
+					if(block && *p->arena == block)
+						block->used = used;
+				} else if(!p->scratch)
+					ligolw_table_free_cells(table, cells, p->prog->columns);
+				continue;
+			}
+		}
+
+		for(c = 0; c < table->n_columns; c++) {
+			if(p->prog && p->prog->columns[c])
+				/* already done */
+				continue;
+			if(p->selected && !p->selected[c])
+				/* column not wanted */
+				continue;
+			if(table_parser_convert(p, cells, c, &buf) < 0)
+				return -1;
+		}
+
+		return 1;
+	}
+
+	return 0;
+}
+
+
+/*
+ * Pass the rest of the parser's rows to row_callback() using one row, and
+ * one scratch buffer for string and blob values, for all of them.  See
+ * LIGOLW_TABLE_REUSE_ROW.  Returns < 0 on failure.
+ */
+
+
+static int table_parse_reusing_row(struct table_parser *p, int (row_callback)(struct ligolw_table *, struct ligolw_table_row *, void *), void *callback_data)
+{
+	struct ligolw_table_row row;
+	int result;
+
+	p->scratch_size = 4096;
+	p->scratch = malloc(p->scratch_size);
+	row.table = p->table;
+	row.cells = calloc(p->table->n_columns + 1, sizeof(*row.cells));
+	if(!p->scratch || !row.cells) {
+		free(row.cells);
+		return -1;
+	}
+
+	p->table->reused_row = &row;
+	while((result = table_parser_next(p, row.cells)) > 0)
+		if(row_callback(p->table, &row, callback_data)) {
+			result = -1;
+			break;
+		}
+	p->table->reused_row = NULL;
+	free(row.cells);
+
+	return result;
+}
+
+
+/*
+ * Grow the table's rows array, and its block of cells, to hold n rows.
+ * The rows' cells pointers are updated to the block's new location.  The
+ * new cells are not zeroed, that is done to each row's as it is claimed,
+ * so that room reserved for rows that never come is not touched.
+ * Returns < 0 on failure, leaving the table as it was.
+ */
+
+
+static int table_grow_rows(struct ligolw_table *table, int n)
+{
+	struct ligolw_table_row *rows;
+	union ligolw_cell *cells;
+	int i;
+
+	if(n <= table->rows_capacity)
+		return 0;
+
+	rows = realloc(table->rows, (size_t) n * sizeof(*rows));
+	if(!rows)
+		return -1;
+	table->rows = rows;
+	cells = realloc(table->cells, ((size_t) n * table->n_columns + 1) * sizeof(*cells));
+	if(!cells)
+		return -1;
+	table->cells = cells;
+	table->rows_capacity = n;
+
+	for(i = 0; i < table->n_rows; i++)
+		rows[i].cells = cells + (size_t) i * table->n_columns;
+
+	return 0;
+}
+
+
+/*
+ * The default row builder.  Decodes the rest of the parser's rows
+ * directly into the table's rows array and block of cells, which grow
+ * geometrically.  When they are full, the number of rows is estimated
+ * from the length of those decoded so far, and if it is more room is made
+ * for up to LIGOLW_TABLE_MAX_GROWTH times as many, as a hint:  if that
+ * can't be had the arrays just double.  Returns < 0 on failure.
+ */
+
+
+static int table_parse_into_table(struct table_parser *p)
+{
+	struct ligolw_table *table = p->table;
+	const char *start = p->txt;
+	int result;
+
+	do {
+		union ligolw_cell *cells;
+
+		if(table->n_rows == table->rows_capacity) {
+			int n = table_next_capacity(table);
+			if(n < 0)
+				return -1;
+			if(table->n_rows && !p->prog && p->txt < p->end) {
+				/* rows are usually about the same length,
+				 * but the first few might not be typical,
+				 * so the estimate is limited.  not done if
+				 * a filter might reject most of them */
+				double estimate = (double) table->n_rows * (p->end - start) / (p->txt - start) + 1;
+				double limit = (double) table->rows_capacity * LIGOLW_TABLE_MAX_GROWTH;
+				if(estimate > limit)
+					estimate = limit;
+				if(estimate > INT_MAX)
+					estimate = INT_MAX;
+				if(estimate > n)
+					/* only a hint, if the room can't be
+					 * had carry on doubling */
+					table_grow_rows(table, (int) estimate);
+			}
+			if(table_grow_rows(table, n) < 0)
+				return -1;
+		}
+
+		cells = table->cells + (size_t) table->n_rows * table->n_columns;
+		memset(cells, 0, table->n_columns * sizeof(*cells));
+		result = table_parser_next(p, cells);
+		if(result < 0) {
+			if(!p->arena)
+				ligolw_table_free_cells(table, cells, NULL);
+			return -1;
+		}
+		if(result) {
+			table->rows[table->n_rows].table = table;
+			table->rows[table->n_rows].cells = cells;
+			table->n_rows++;
+		}
+	} while(result);
+
+	return 0;
+}
+
+
+/*
+ * Same as ligolw_table_parse() but with options controlling how the Table
+ * is parsed.  options may be NULL, which is equivalent to all options
+ * being zeroed.
+ *
+ * If options->columns is not NULL, it is a NULL-terminated array of the
+ * names of the columns to be converted.  The tokens of the other columns
+ * are found but not converted, and their cells are left zeroed (string
+ * and blob cells are NULL), which saves the cost of converting and
+ * allocating the data of columns the calling code does not need.
+ *
+ * If options->filter is not NULL, it is an expression made of comparisons
+ * of columns to values, combined with AND and OR, and only rows for which
+ * it is true are passed to row_callback().  The columns the filter
+ * examines are converted first, and the remainder of a row that fails the
+ * filter is skipped without being converted.  The filtered columns' cells
+ * are populated even if options->columns does not name them.  It is an
+ * error for the filter to name a column the table does not have, to
+ * compare a blob, or to order complex numbers.  Strings are compared with
+ * strcmp();  no comparison involving a NaN is true except NE.
+ *
+ * If options->flags includes LIGOLW_TABLE_REUSE_ROW and row_callback is
+ * not NULL, the library owns the row passed to row_callback(), and passes
+ * the same row, with the same cells array, for every row.  String and blob
+ * cells point into a buffer that is overwritten by the next row, so
+ * nothing is allocated per row.  row_callback() must copy what it needs
+ * before returning, and must not free() the row, its cells, or their data,
+ * nor keep pointers into them;  in particular ligolw_cell_to_c(),
+ * ligolw_cell_string_copy() and ligolw_table_unpack_row() must not be used
+ * on its string and blob cells, ligolw_cell_string_copy_keep() can be used
+ * instead.  table->reused_row points to the row while the Stream is being
+ * parsed, ligolw_table_free_row_data() and ligolw_table_free_row() do
+ * nothing to it, so call-backs written to free their rows with
+ * ligolw_table_free_row() work either way.  The flag is ignored when the
+ * default row builder is used.
+ *
+ * The default row builder allocates the string and blob data of the rows
+ * from an arena owned by the table, large blocks of memory that
+ * ligolw_table_free() frees without visiting the rows.  The cells' data
+ * must then not be free()ed or taken by the calling code, so
+ * ligolw_cell_to_c() and ligolw_cell_string_copy() must not be used on
+ * them;  ligolw_table_unpack_row() and ligolw_unpacking_plan_apply() can
+ * be, they make copies for the destinations.  If options->flags includes
+ * LIGOLW_TABLE_OWN_STRINGS each value is allocated separately instead,
+ * as it is for rows passed to a row call-back, and can be taken.
+ *
+ * If options->flags includes LIGOLW_TABLE_BORROW_STRINGS, string values
+ * that contain no escape sequences are not copied at all.  Each is
+ * null-terminated in the Stream's text, by overwriting the quote or
+ * delimiter that follows it, and its cell points there;  only escaped
+ * values are decoded into the arena or the scratch buffer.  This applies
+ * to the default row builder, unless LIGOLW_TABLE_OWN_STRINGS is also
+ * given, and to LIGOLW_TABLE_REUSE_ROW, and is otherwise ignored.  The
+ * cells are then valid only as long as the document is, and the Stream
+ * element's text is left modified:  it cannot be parsed again, or
+ * written out.  If the Stream's text was left in a read-only mapping by
+ * ezxml_parse_file_ro() the flag has no effect.
+ */
+
+
+struct ligolw_table *ligolw_table_parse_opts(ezxml_t elem, const struct ligolw_table_options *options, int (row_callback)(struct ligolw_table *, struct ligolw_table_row *, void *), void *callback_data)
+{
+	struct table_parser p;
+	struct ligolw_table_row *row = NULL;
+	bool borrow;
+	int result;
+
+	/* this simplifies error checking in calling code */
+	if(!elem)
+		return NULL;
+
+	if(table_parser_init(&p, elem, options) < 0)
+		goto error;
+
+	if(!p.txt) {
+		/* no Stream */
+		table_parser_free(&p);
+		return p.table;
+	}
+
+	/* text left in a read-only mapping can't be terminated in place */
+	borrow = options && options->flags & LIGOLW_TABLE_BORROW_STRINGS && !(ezxml_child(elem, "Stream")->flags & EZXML_TXTS);
+
+	if(row_callback && options && options->flags & LIGOLW_TABLE_REUSE_ROW) {
+		p.borrow = borrow;
+		if(table_parse_reusing_row(&p, row_callback, callback_data) < 0)
+			goto error;
+		table_parser_free(&p);
+		return p.table;
+	}
+
+	if(!row_callback) {
+		if(!(options && options->flags & LIGOLW_TABLE_OWN_STRINGS)) {
+			p.arena = &p.table->arena;
+			p.borrow = borrow;
+			p.table->borrowed_strings = borrow;
+		}
+		if(table_parse_into_table(&p) < 0)
+			goto error;
+		table_parser_free(&p);
+		return p.table;
+	}
+
+	do {
+		if(!row) {
+			row = malloc(sizeof(*row));
+			if(!row)
+				goto error;
+			row->table = p.table;
+			row->cells = calloc(p.table->n_columns, sizeof(*row->cells));
+			if(!row->cells)
+				goto error;
+		}
+
+		result = table_parser_next(&p, row->cells);
+		if(result < 0)
+			goto error;
+		if(result) {
+			/* row_callback takes ownership of row */
+			struct ligolw_table_row *complete = row;
+			row = NULL;
+			if(row_callback(p.table, complete, callback_data))
+				goto error;
+		}
+	} while(result);
+
+	if(row) {
+		/* allocated for a row that didn't come */
+		free(row->cells);
+		free(row);
+	}
+	table_parser_free(&p);
+	return p.table;
+
+error:
+	if(row) {
+		if(row->cells)
+			ligolw_table_free_row_data(p.table, row);
+		free(row);
+	}
+	table_parser_free(&p);
+	ligolw_table_free(p.table);
+	return NULL;
+}
+
+
+/*
+ * Parse an ezxml_t Table element, passing the rows to batch_callback() in
+ * blocks instead of one at a time.  options may be NULL, and is
+ * interpreted as for ligolw_table_parse_opts().  options->batch_size sets
+ * the number of rows in each block, or LIGOLW_TABLE_BATCH_SIZE if it is 0;
+ * the last block can be shorter.
+ *
+ * The struct ligolw_table_batch passed to batch_callback(), and the rows
+ * and cells in it, are owned by the library and re-used for each block,
+ * so nothing is allocated per row except string and blob data.  The cells
+ * of row i are cells[i * n_columns] through cells[(i + 1) * n_columns -
+ * 1], and rows[i].cells points to them so that each row can be handed to
+ * ligolw_table_unpack_row() or ligolw_row_get_cell().  After the call-back
+ * returns, the library frees all string and blob data remaining in the
+ * block's cells.  A call-back that wants to keep a string or blob must
+ * take ownership of it by setting the cell's pointer to NULL, which
+ * ligolw_cell_to_c(), ligolw_cell_string_copy() and
+ * ligolw_table_unpack_row() all do.  The call-back returns 0 to indicate
+ * success, non-zero to indicate failure.
+ *
+ * Returns the address of a new struct ligolw_table describing the table's
+ * columns (its rows array is empty), which the calling code must free with
+ * ligolw_table_free(), or NULL on failure.
+ */
+
+
+struct ligolw_table *ligolw_table_parse_batches(ezxml_t elem, const struct ligolw_table_options *options, int (batch_callback)(struct ligolw_table *, struct ligolw_table_batch *, void *), void *callback_data)
+{
+	struct table_parser p;
+	struct ligolw_table_batch batch = {NULL, 0, NULL, NULL, 0};
+	int size = options && options->batch_size > 0 ? options->batch_size : LIGOLW_TABLE_BATCH_SIZE;
+	int i, result;
+
+	/* this simplifies error checking in calling code */
+	if(!elem)
+		return NULL;
+
+	if(table_parser_init(&p, elem, options) < 0)
+		goto error;
+	if(!p.txt) {
+		/* no Stream */
+		table_parser_free(&p);
+		return p.table;
+	}
+
+	batch.table = p.table;
+	batch.rows = malloc(size * sizeof(*batch.rows));
+	batch.cells = calloc((size_t) size * p.table->n_columns + 1, sizeof(*batch.cells));
+	if(!batch.rows || !batch.cells)
+		goto error;
+	for(i = 0; i < size; i++) {
+		batch.rows[i].table = p.table;
+		batch.rows[i].cells = batch.cells + (size_t) i * p.table->n_columns;
+	}
+
+	do {
+		result = table_parser_next(&p, batch.rows[batch.n_rows].cells);
+		if(result < 0) {
+			batch.n_rows++;
+			goto error;
+		}
+		batch.n_rows += result;
+		if(batch.n_rows == size || (!result && batch.n_rows)) {
+			if(batch_callback(p.table, &batch, callback_data))
+				goto error;
+			for(i = 0; i < batch.n_rows; i++)
+				ligolw_table_free_cells(p.table, batch.rows[i].cells, NULL);
+			batch.first_row += batch.n_rows;
+			batch.n_rows = 0;
+		}
+	} while(result);
+
+	free(batch.rows);
+	free(batch.cells);
+	table_parser_free(&p);
+	return p.table;
+
+error:
+	for(i = 0; i < batch.n_rows; i++)
+		ligolw_table_free_cells(p.table, batch.rows[i].cells, NULL);
+	free(batch.rows);
+	free(batch.cells);
+	table_parser_free(&p);
+	ligolw_table_free(p.table);
+	return NULL;
+}
+
+
+/*
+ * A piece of a Stream for ligolw_table_parse_parallel(), and the rows
+ * decoded from it.
+ */
+
+
+struct table_chunk {
+	/* the chunk holds the rows that start at or after start and before
+	 * stop.  start is a guess at where a row starts until it has been
+	 * confirmed */
+	const char *start;
+	const char *stop;
+	/* where the chunk's last row ended, which is the start of the
+	 * first row at or after stop */
+	const char *end;
+	/* the cells of the chunk's rows, in row order */
+	int n_rows;
+	int capacity;
+	union ligolw_cell *cells;
+	/* if the table's rows are stored with an arena, the chunk's own
+	 * arena, holding its rows' string and blob data */
+	struct ligolw_table_arena *arena;
+	/* the index of the chunk's first row in the table */
+	int first_row;
+	/* table_chunk_parse()'s result, and whether it is available */
+	int result;
+	bool done;
+};
+
+
+/*
+ * State shared by the threads of ligolw_table_parse_parallel().
+ */
+
+
+struct table_parallel {
+	struct table_parser *parser;
+	int (*batch_callback)(struct ligolw_table *, struct ligolw_table_batch *, void *);
+	void *callback_data;
+	int batch_size;
+	int n_chunks;
+	struct table_chunk *chunks;
+	/* the next chunk for a thread to work on */
+	int next;
+	/* set when a thread fails, the others stop taking chunks */
+	bool failed;
+	pthread_mutex_t lock;
+	pthread_cond_t done;
+};
+
+
+/*
+ * Guess where the first row at or after txt starts.  Documents are written
+ * with each row on a line of its own, ending with the delimiter, so the
+ * guess is the position after the first delimiter that is followed by
+ * nothing but white space to the end of its line.  This is not certain to
+ * be the start of a row, the newline might be inside a quoted string,
+ * for example, and ligolw_table_parse_parallel() confirms it.  Returns
+ * end if there is no such delimiter.
+ */
+
+
+static const char *table_guess_row_start(const char *txt, const char *end, char delimiter)
+{
+	const char *newline;
+
+	for(; (newline = memchr(txt, '\n', end - txt)); txt = newline + 1) {
+		const char *c = newline;
+		while(c > txt && isspace((unsigned char) c[-1]))
+			c--;
+		if(c > txt && c[-1] == delimiter)
+			return c;
+	}
+
+	return end;
+}
+
+
+/*
+ * Free the chunk's rows.  String and blob data that has not been taken
+ * from the cells is freed as well.
+ */
+
+
+static void table_chunk_clear(const struct ligolw_table *table, struct table_chunk *chunk)
+{
+	int i;
+
+	if(chunk->arena) {
+		table_arena_free(chunk->arena);
+		chunk->arena = NULL;
+	} else
+		for(i = 0; i < chunk->n_rows; i++)
+			ligolw_table_free_cells(table, chunk->cells + (size_t) i * table->n_columns, NULL);
+	free(chunk->cells);
+	chunk->cells = NULL;
+	chunk->n_rows = chunk->capacity = 0;
+}
+
+
+/*
+ * Decode the chunk's rows, starting at chunk->start, with the columns and
+ * filter of the Stream's parser.  Each chunk has its own tokenizer state,
+ * so chunks can be decoded by different threads at the same time.  Returns
+ * < 0 on failure, in which case the chunk's rows must still be cleared
+ * with table_chunk_clear().
+ */
+
+
+static int table_chunk_parse(const struct table_parser *stream, struct table_chunk *chunk)
+{
+	const struct ligolw_table *table = stream->table;
+	struct table_parser p;
+	int result = -1;
+
+	memset(&p, 0, sizeof(p));
+	p.table = stream->table;
+	p.txt = chunk->start;
+	p.end = stream->end;
+	p.stop = chunk->stop;
+	p.selected = stream->selected;
+	p.prog = stream->prog;
+	if(stream->arena)
+		p.arena = &chunk->arena;
+	p.index = ligolw_stream_index_new(p.txt, p.end, table->delimiter);
+	p.tokens = malloc((table->n_columns + 1) * sizeof(*p.tokens));
+	if(!p.index || !p.tokens)
+		goto done;
+
+	do {
+		union ligolw_cell *cells;
+
+		if(chunk->n_rows == chunk->capacity) {
+			int n = chunk->capacity ? 2 * chunk->capacity : LIGOLW_TABLE_BATCH_SIZE;
+			cells = realloc(chunk->cells, ((size_t) n * table->n_columns + 1) * sizeof(*cells));
+			if(!cells) {
+				result = -1;
+				break;
+			}
+			memset(cells + (size_t) chunk->capacity * table->n_columns, 0, ((size_t) (n - chunk->capacity) * table->n_columns + 1) * sizeof(*cells));
+			chunk->cells = cells;
+			chunk->capacity = n;
+		}
+
+		cells = chunk->cells + (size_t) chunk->n_rows * table->n_columns;
+		result = table_parser_next(&p, cells);
+		if(result < 0) {
+			if(!p.arena)
+				ligolw_table_free_cells(table, cells, NULL);
+		} else
+			chunk->n_rows += result;
+	} while(result > 0);
+
+	chunk->end = p.txt;
+
+done:
+	ligolw_stream_index_free(p.index);
+	free(p.tokens);
+	return result;
+}
+
+
+/*
+ * Return the index of the next chunk for a thread to work on, or -1 if
+ * there are none left or a thread has failed.
+ */
+
+
+static int table_parallel_take(struct table_parallel *par)
+{
+	int i = -1;
+
+	pthread_mutex_lock(&par->lock);
+	if(!par->failed && par->next < par->n_chunks)
+		i = par->next++;
+	pthread_mutex_unlock(&par->lock);
+
+	return i;
+}
+
+
+static void table_parallel_fail(struct table_parallel *par)
+{
+	pthread_mutex_lock(&par->lock);
+	par->failed = true;
+	pthread_mutex_unlock(&par->lock);
+}
+
+
+/*
+ * Thread:  decode chunks.  The guesses at where they start are confirmed
+ * by the calling thread, which is told as each chunk is finished.
+ */
+
+
+static void *table_parallel_parse(void *data)
+{
+	struct table_parallel *par = data;
+	int i;
+
+	while((i = table_parallel_take(par)) >= 0) {
+		int result = table_chunk_parse(par->parser, &par->chunks[i]);
+		pthread_mutex_lock(&par->lock);
+		par->chunks[i].result = result;
+		par->chunks[i].done = true;
+		pthread_cond_broadcast(&par->done);
+		pthread_mutex_unlock(&par->lock);
+	}
+
+	return NULL;
+}
+
+
+/*
+ * Wait for the chunk to be decoded, and confirm that it starts where the
+ * previous chunk ended.  If not, its rows were found by starting from the
+ * wrong place, and it is decoded again from the right one.  Returns < 0
+ * on failure.
+ */
+
+
+static int table_parallel_confirm(struct table_parallel *par, int i, const char *start)
+{
+	struct table_chunk *chunk = &par->chunks[i];
+
+	pthread_mutex_lock(&par->lock);
+	while(!chunk->done)
+		pthread_cond_wait(&par->done, &par->lock);
+	pthread_mutex_unlock(&par->lock);
+
+	if(chunk->start != start) {
+		table_chunk_clear(par->parser->table, chunk);
+		chunk->start = start;
+		chunk->result = table_chunk_parse(par->parser, chunk);
+	}
+
+	return chunk->result;
+}
+
+
+/*
+ * Pass the chunk's rows to the batch call-back in blocks of at most
+ * batch_size rows.  rows must have room for batch_size rows.  Returns < 0
+ * on failure.
+ */
+
+
+static int table_chunk_deliver(struct table_parallel *par, struct table_chunk *chunk, struct ligolw_table_row *rows)
+{
+	struct ligolw_table *table = par->parser->table;
+	struct ligolw_table_batch batch;
+	int r, i;
+
+	batch.table = table;
+	batch.rows = rows;
+	for(r = 0; r < chunk->n_rows; r += batch.n_rows) {
+		batch.n_rows = chunk->n_rows - r < par->batch_size ? chunk->n_rows - r : par->batch_size;
+		batch.cells = chunk->cells + (size_t) r * table->n_columns;
+		batch.first_row = chunk->first_row + r;
+		for(i = 0; i < batch.n_rows; i++) {
+			rows[i].table = table;
+			rows[i].cells = batch.cells + (size_t) i * table->n_columns;
+		}
+		if(par->batch_callback(table, &batch, par->callback_data))
+			return -1;
+	}
+
+	return 0;
+}
+
+
+/*
+ * Thread:  pass confirmed chunks to the batch call-back.
  */
 
 
-static const char *ligolw_strip_column_name(const char *Name)
+static void *table_parallel_deliver(void *data)
 {
-	return ligolw_strip_name(Name, NULL);
+	struct table_parallel *par = data;
+	struct ligolw_table_row *rows = malloc(par->batch_size * sizeof(*rows));
+	int i;
+
+	if(!rows)
+		table_parallel_fail(par);
+	while(rows && (i = table_parallel_take(par)) >= 0) {
+		if(table_chunk_deliver(par, &par->chunks[i], rows) < 0)
+			table_parallel_fail(par);
+		table_chunk_clear(par->parser->table, &par->chunks[i]);
+	}
+	free(rows);
+
+	return NULL;
 }
 
 
 /*
- * Default row builder call-back.  Appends the contents of the row object
- * to the rows array in table.
+ * Thread:  move confirmed chunks' rows into the table's rows array, which
+ * has room for all of them.  The table takes ownership of the string and
+ * blob data.
  */
 
 
-int ligolw_table_default_row_callback(struct ligolw_table *table, struct ligolw_table_row *row, void *ignored)
+static void *table_parallel_collect(void *data)
 {
-	table->rows = realloc(table->rows, (table->n_rows + 1) * sizeof(*table->rows));
-	table->rows[table->n_rows] = *row;
-	table->n_rows++;
-	free(row);
-	return 0;
+	struct table_parallel *par = data;
+	struct ligolw_table *table = par->parser->table;
+	int i, r;
+
+	while((i = table_parallel_take(par)) >= 0) {
+		struct table_chunk *chunk = &par->chunks[i];
+		union ligolw_cell *cells = table->cells + (size_t) chunk->first_row * table->n_columns;
+		memcpy(cells, chunk->cells, (size_t) chunk->n_rows * table->n_columns * sizeof(*cells));
+		for(r = 0; r < chunk->n_rows; r++) {
+			table->rows[chunk->first_row + r].table = table;
+			table->rows[chunk->first_row + r].cells = cells + (size_t) r * table->n_columns;
+		}
+		free(chunk->cells);
+		chunk->cells = NULL;
+		chunk->n_rows = chunk->capacity = 0;
+	}
+
+	return NULL;
 }
 
 
 /*
- * Return the address of the ligolw_cell corresponding to the named column
- * If type is not NULL, the cell type is stored in the location it points
- * to.  Returns NULL on error;
+ * Run func() in n_threads threads, on the chunks from the first, and wait
+ * for them to finish.  The calling thread runs it too if threads cannot be
+ * started.
  */
 
 
-union ligolw_cell *ligolw_row_get_cell(const struct ligolw_table_row *row, const char *name, enum ligolw_cell_type *type)
+static void table_parallel_run(struct table_parallel *par, int n_threads, void *(*func)(void *))
 {
-	int i = ligolw_table_get_column(row->table, name, type);
-	return i >= 0 ? &row->cells[i] : NULL;
+	pthread_t *threads = malloc(n_threads * sizeof(*threads));
+	int i, n = 0;
+
+	par->next = 0;
+	for(i = 0; threads && i < n_threads; i++, n++)
+		if(pthread_create(&threads[i], NULL, func, par))
+			break;
+	if(!n)
+		func(par);
+	for(i = 0; i < n; i++)
+		pthread_join(threads[i], NULL);
+	free(threads);
 }
 
 
 /*
- * Parse an ezxml_t Table element into a struct ligolw_table structure.  If
- * row_callback() is NULL, then the default row builder is used, which
- * inserts the rows directly into the ligolw_table structure.  Calling code
- * can provide it's own function, which will be called after each row is
- * constructed.  This allows the data contained in each row to be
- * redirected, for example to store it in an application-specific type, or
- * process it on-the-fly to produce some kind of output directly.  The
- * call-back function will be passed the address of the current struct
- * ligolw_table as its first argument, the address of a newly allocated
- * struct ligolw_table_row as its second, and the callback_data pointer as
- * its third argument.  The row_callback() function takes ownership of the
- * row structure and the data contained within it, and is responsible for
- * freeing all memory associated with the object when it no longer requires
- * it.  All allocated cell data can be freed with
- * ligolw_table_free_row_data(), and the struct ligolw_table_row freed with
- * free().  The call-back returns 0 to indicate success, non-zero to
- * indicate failure.
+ * Parse an ezxml_t Table element using several threads.  options may be
+ * NULL, and is interpreted as for ligolw_table_parse_batches(), with
+ * options->n_threads giving the number of threads, or one per on-line
+ * processor if it is 0.
  *
- * If the Table element is empty, the row_callback() function will not be
- * called.
+ * The Stream's text is split into pieces at what look like row boundaries
+ * (each row is usually on a line of its own), and the pieces are decoded
+ * by the threads.  Because a newline can also occur inside a quoted
+ * string, each piece is then confirmed to start where the previous one's
+ * last row ended, in order;  a piece that does not is decoded again from
+ * the right place by the calling thread, so the result is always the same
+ * as that of ligolw_table_parse_opts(), only the speed is affected.
  *
- * ligolw_table_parse() returns the pointer to the new struct ligolw_table
- * structure on success, NULL on failure.
+ * If batch_callback is NULL the rows are stored in the table, as by
+ * ligolw_table_parse_opts()'s default row builder, except that
+ * LIGOLW_TABLE_BORROW_STRINGS is ignored and the string values are always
+ * copied:  the pieces are decoded before it is known whether they start
+ * where rows do, and terminating values in place in a piece that does not
+ * would damage the text it is decoded again from.  Otherwise they are
+ * passed to batch_callback() in blocks, as by
+ * ligolw_table_parse_batches(), with the same rules for the ownership of
+ * their data.  batch->first_row gives the index of each block's first row
+ * among all the rows passed.  The blocks are passed in order, from the
+ * calling thread, as their pieces are confirmed.  If options->flags
+ * includes LIGOLW_TABLE_UNORDERED, the blocks are instead passed once all
+ * pieces have been decoded, in no particular order, by the threads, so
+ * batch_callback() must be safe to call from several threads at once.  If
+ * batch_callback() reports a failure, blocks not yet passed might still be
+ * passed to it by other threads.
+ *
+ * Returns the address of a new struct ligolw_table, which the calling
+ * code must free with ligolw_table_free(), or NULL on failure.
  */
 
 
-struct ligolw_table *ligolw_table_parse(ezxml_t elem, int (row_callback)(struct ligolw_table *, struct ligolw_table_row *, void *), void *callback_data)
+struct ligolw_table *ligolw_table_parse_parallel(ezxml_t elem, const struct ligolw_table_options *options, int (batch_callback)(struct ligolw_table *, struct ligolw_table_batch *, void *), void *callback_data)
 {
-	struct ligolw_table *table;
-	char *txt;
-	ezxml_t column;
-	ezxml_t stream;
+	struct table_parser p;
+	struct table_parallel par;
+	struct ligolw_table_row *rows = NULL;
+	pthread_t *threads = NULL;
+	const char *end;
+	int n_threads = options && options->n_threads > 0 ? options->n_threads : (int) sysconf(_SC_NPROCESSORS_ONLN);
+	int n_started = 0;
+	int n_rows = 0;
+	int i;
 
 	/* this simplifies error checking in calling code */
 	if(!elem)
 		return NULL;
 
-	table = malloc(sizeof(*table));
-	if(!table)
-		return NULL;
-
-	table->name = ligolw_strip_table_name(ezxml_attr(elem, "Name"));
-
-	table->delimiter = '\0';
-	table->n_columns = 0;
-	table->columns = NULL;
-	table->n_rows = 0;
-	table->rows = NULL;
-
-	/* the table can now be free()ed with ligolw_table_free() */
-
-	for(column = ezxml_child(elem, "Column"); column; column = column->next) {
-		table->columns = realloc(table->columns, (table->n_columns + 1) * sizeof(*table->columns));
-
-		table->columns[table->n_columns].name = ligolw_strip_column_name(ezxml_attr(column, "Name"));
-		table->columns[table->n_columns].table = table;
-		table->columns[table->n_columns].type = ligolw_type_name_to_enum(ezxml_attr(column, "Type"));
-
-		table->n_columns++;
+	memset(&par, 0, sizeof(par));
+	if(table_parser_init(&p, elem, options) < 0)
+		goto error;
+	if(!p.txt) {
+		/* no Stream */
+		table_parser_free(&p);
+		return p.table;
 	}
 
-	stream = ezxml_child(elem, "Stream");
-	if(!stream) {
-		/* DTD allows Table to have 0 Stream children */
-		return table;
+	par.parser = &p;
+	par.batch_callback = batch_callback;
+	par.callback_data = callback_data;
+	par.batch_size = options && options->batch_size > 0 ? options->batch_size : LIGOLW_TABLE_BATCH_SIZE;
+	pthread_mutex_init(&par.lock, NULL);
+	pthread_cond_init(&par.done, NULL);
+
+	/* split the text into chunks.  if the delimiter is white space it
+	 * can't be told from the padding at the ends of lines, and the
+	 * text is not split */
+	if(n_threads < 1)
+		n_threads = 1;
+	par.n_chunks = (p.end - p.txt) / LIGOLW_TABLE_MIN_CHUNK;
+	if(par.n_chunks > LIGOLW_TABLE_CHUNKS_PER_THREAD * n_threads)
+		par.n_chunks = LIGOLW_TABLE_CHUNKS_PER_THREAD * n_threads;
+	if(par.n_chunks < 1 || n_threads == 1 || isspace((unsigned char) p.table->delimiter))
+		par.n_chunks = 1;
+	if(!batch_callback && !(options && options->flags & LIGOLW_TABLE_OWN_STRINGS))
+		p.arena = &p.table->arena;
+	if(par.n_chunks == 1 && !batch_callback) {
+		/* nothing to do in parallel */
+		if(table_parse_into_table(&p) < 0)
+			goto error;
+		table_parser_free(&p);
+		pthread_cond_destroy(&par.done);
+		pthread_mutex_destroy(&par.lock);
+		return p.table;
 	}
-
-	table->delimiter = ligolw_stream_delimiter(stream);
-	if(table->delimiter < 0) {
-		ligolw_table_free(table);
-		return NULL;
+	par.chunks = calloc(par.n_chunks, sizeof(*par.chunks));
+	if(!par.chunks)
+		goto error;
+	par.chunks[0].start = p.txt;
+	for(i = 1; i < par.n_chunks; i++) {
+		const char *guess = p.txt + (p.end - p.txt) / par.n_chunks * i;
+		if(guess < par.chunks[i - 1].start)
+			guess = par.chunks[i - 1].start;
+		par.chunks[i].start = par.chunks[i - 1].stop = table_guess_row_start(guess, p.end, p.table->delimiter);
 	}
-
-	if(ligolw_stream_check_encoding(stream) != ligolw_stream_enc_text) {
-		ligolw_table_free(table);
-		return NULL;
+	par.chunks[par.n_chunks - 1].stop = p.end;
+
+	/* decode the chunks.  the calling thread confirms them in order as
+	 * they finish, and, unless the order does not matter, passes them
+	 * to the call-back */
+	threads = malloc(n_threads * sizeof(*threads));
+	if(!threads)
+		goto error;
+	if(batch_callback && !(options && options->flags & LIGOLW_TABLE_UNORDERED)) {
+		rows = malloc(par.batch_size * sizeof(*rows));
+		if(!rows)
+			goto error;
 	}
-
-	if(!row_callback)
-		row_callback = ligolw_table_default_row_callback;
-
-	for(txt = stream->txt; txt && *txt; ) {
-		int c;
-		struct ligolw_table_row *row = malloc(sizeof(*row));
-		union ligolw_cell *cells = malloc(table->n_columns * sizeof(*cells));
-		if(!row || !cells) {
-			free(row);
-			free(cells);
-			ligolw_table_free(table);
-			return NULL;
-		}
-		row->table = table;
-		row->cells = cells;
-
-		for(c = 0; c < table->n_columns; c++) {
-			char *start, *end;
-
-			ligolw_stream_next_token(&txt, &start, &end, table->delimiter);
-
-			/* null-terminate current token.  this does not
-			 * interfer with the exit test for the loop over
-			 * txt because end and txt can only point to the
-			 * same address if that address is the
-			 * null-terminated end of the stream's text */
-			*end = '\0';
-
-			/* if the token is a string or blob type, a decoded
-			 * copy gets made.  we own that memory and need to
-			 * free() it when finished */
-			ligolw_cell_from_txt(&cells[c], table->columns[c].type, start);
+	for(n_started = 0; n_started < n_threads && n_started < par.n_chunks; n_started++)
+		if(pthread_create(&threads[n_started], NULL, table_parallel_parse, &par))
+			break;
+	if(!n_started)
+		/* no threads, do it ourselves */
+		table_parallel_parse(&par);
+	for(end = p.txt, i = 0; i < par.n_chunks; end = par.chunks[i++].end) {
+		if(table_parallel_confirm(&par, i, end) < 0)
+			goto error;
+		if(n_rows > INT_MAX - par.chunks[i].n_rows)
+			goto error;
+		par.chunks[i].first_row = n_rows;
+		n_rows += par.chunks[i].n_rows;
+		if(rows) {
+			if(table_chunk_deliver(&par, &par.chunks[i], rows) < 0)
+				goto error;
+			table_chunk_clear(p.table, &par.chunks[i]);
 		}
-
-		/* row_callback takes ownership of row */
-		if(row_callback(table, row, callback_data)) {
-			ligolw_table_free(table);
-			return NULL;
+	}
+	for(; n_started; n_started--)
+		pthread_join(threads[n_started - 1], NULL);
+
+	if(!batch_callback) {
+		/* move the rows into the table.  every cell is written by
+		 * the threads, so the block is not zeroed first */
+		p.table->rows = malloc((n_rows + 1) * sizeof(*p.table->rows));
+		p.table->cells = malloc(((size_t) n_rows * p.table->n_columns + 1) * sizeof(*p.table->cells));
+		if(!p.table->rows || !p.table->cells)
+			goto error;
+		p.table->rows_capacity = n_rows;
+		table_parallel_run(&par, n_threads, table_parallel_collect);
+		p.table->n_rows = n_rows;
+		/* the table takes over the chunks' arenas */
+		for(i = 0; i < par.n_chunks; i++) {
+			table_arena_splice(&p.table->arena, par.chunks[i].arena);
+			par.chunks[i].arena = NULL;
 		}
+	} else if(!rows) {
+		/* the order does not matter, the threads pass the chunks
+		 * to the call-back */
+		table_parallel_run(&par, n_threads, table_parallel_deliver);
+		if(par.failed)
+			goto error;
 	}
 
-	return table;
+	free(par.chunks);
+	free(threads);
+	free(rows);
+	pthread_cond_destroy(&par.done);
+	pthread_mutex_destroy(&par.lock);
+	table_parser_free(&p);
+	return p.table;
+
+error:
+	if(n_started) {
+		table_parallel_fail(&par);
+		for(; n_started; n_started--)
+			pthread_join(threads[n_started - 1], NULL);
+	}
+	for(i = 0; par.chunks && i < par.n_chunks; i++)
+		table_chunk_clear(p.table, &par.chunks[i]);
+	if(par.parser) {
+		pthread_cond_destroy(&par.done);
+		pthread_mutex_destroy(&par.lock);
+	}
+	free(par.chunks);
+	free(threads);
+	free(rows);
+	table_parser_free(&p);
+	ligolw_table_free(p.table);
+	return NULL;
 }
 
 
 /*
- * Free the data for one row of a struct ligolw_table.  If the row object
- * must also be free()'ed the calling code must do that.
+ * Free the string and blob data in an array of cells belonging to a row
+ * of the table, and zero the cells.  If which is not NULL, only the cells
+ * of the columns for which it is true are cleared.
  */
 
 
-void ligolw_table_free_row_data(struct ligolw_table *table, struct ligolw_table_row *row)
+void ligolw_table_free_cells(const struct ligolw_table *table, union ligolw_cell *cells, const bool *which)
 {
 	int c;
-	if(!row)
-		return;
-	assert(table);
-	for(c = 0; c < table->n_columns; c++)
+
+	for(c = 0; c < table->n_columns; c++) {
+		if(which && !which[c])
+			continue;
 		switch(table->columns[c].type) {
 		case ligolw_cell_type_char_s:
 		case ligolw_cell_type_char_v:
 		case ligolw_cell_type_ilwdchar:
 		case ligolw_cell_type_ilwdchar_u:
 		case ligolw_cell_type_lstring:
-			free(row->cells[c].as_string);
+			free(cells[c].as_string);
 			break;
 
 		case ligolw_cell_type_blob:
-			free(row->cells[c].as_blob.data);
+			free(cells[c].as_blob.data);
 			break;
 
 		default:
 			break;
 		}
-	free(row->cells);
+		memset(&cells[c], 0, sizeof(cells[c]));
+	}
+}
+
+
+/*
+ * Is the row's data in the table's block of cells?
+ */
+
+
+static bool table_row_in_block(const struct ligolw_table *table, const struct ligolw_table_row *row)
+{
+	return table->cells && row->cells >= table->cells && row->cells < table->cells + (size_t) table->rows_capacity * table->n_columns + 1;
+}
+
+
+/*
+ * Is the string and blob data of the rows in the table's block of cells
+ * kept by the table's arena or by the document, rather than owned by the
+ * cells?
+ */
+
+
+static bool table_block_data_shared(const struct ligolw_table *table)
+{
+	return table->arena || table->borrowed_strings;
+}
+
+
+/*
+ * Free the data for one row of a struct ligolw_table.  If the row object
+ * must also be free()'ed the calling code must do that.  Does nothing to
+ * the table's reused_row, which belongs to the library.  The string and
+ * blob data of rows in the table's block of cells is left alone if it is
+ * in the table's arena or the document.
+ */
+
+
+void ligolw_table_free_row_data(struct ligolw_table *table, struct ligolw_table_row *row)
+{
+	if(!row)
+		return;
+	assert(table);
+	if(row == table->reused_row)
+		return;
+	if(!table_row_in_block(table, row)) {
+		ligolw_table_free_cells(table, row->cells, NULL);
+		free(row->cells);
+	} else if(!table_block_data_shared(table))
+		ligolw_table_free_cells(table, row->cells, NULL);
 	/* for safety */
 	row->cells = NULL;
 }
 
 
 /*
- * Free a struct ligolw_table.
+ * Free a row passed to a row_callback() and its data, unless it is the
+ * table's reused_row (see ligolw_table_parse_opts()).  Call-backs that
+ * finish with their rows this way work whether or not the rows are
+ * re-used.
+ */
+
+
+void ligolw_table_free_row(struct ligolw_table *table, struct ligolw_table_row *row)
+{
+	if(!row || row == table->reused_row)
+		return;
+	ligolw_table_free_row_data(table, row);
+	free(row);
+}
+
+
+/*
+ * Free a struct ligolw_table.  If the table has an arena, or borrows
+ * strings from the document, all of its rows are in its block of cells,
+ * and their data is freed with the arena without visiting them.
  */
 
 
@@ -249,10 +1730,17 @@ void ligolw_table_free(struct ligolw_table *table)
 {
 	if(table) {
 		int i;
-		for(i = 0; i < table->n_rows; i++)
-			ligolw_table_free_row_data(table, &table->rows[i]);
+		if(table_block_data_shared(table))
+			table_arena_free(table->arena);
+		else
+			for(i = 0; i < table->n_rows; i++)
+				ligolw_table_free_row_data(table, &table->rows[i]);
 		free(table->rows);
+		free(table->cells);
 		free(table->columns);
+		free(table->column_index);
+		ligolw_unpacking_plan_free(table->plan);
+		ezxml_free(table->header);
 	}
 	free(table);
 }
@@ -262,7 +1750,9 @@ void ligolw_table_free(struct ligolw_table *table)
  * Get a column index by name from within a table.  Returns the index of
  * the column within table's columns array (and thus of the corresponding
  * cell within each row's cell array) or -1 on failure.  If type is not
- * NULL, the place it points to is set to the columns's cell_type.
+ * NULL, the place it points to is set to the columns's cell_type.  Tables
+ * made by ligolw_table_new() have a hash table of their columns, and the
+ * time taken does not depend on the number of columns.
  */
 
 
@@ -270,18 +1760,25 @@ int ligolw_table_get_column(struct ligolw_table *table, const char *name, enum l
 {
 	int i;
 
-	for(i = 0; i < table->n_columns; i++)
-		if(!strcmp(table->columns[i].name, name)) {
-			/* found it */
-			if(type)
-				*type = table->columns[i].type;
-			return i;
-		}
+	if(table->column_index) {
+		unsigned j;
+		for(j = ligolw_column_name_hash(name) & table->column_index_mask; (i = table->column_index[j]) >= 0; j = (j + 1) & table->column_index_mask)
+			if(!strcmp(table->columns[i].name, name))
+				goto found;
+	} else
+		for(i = 0; i < table->n_columns; i++)
+			if(!strcmp(table->columns[i].name, name))
+				goto found;
 
 	/* couldn't find that column name */
 	if(type)
 		*type = -1;
 	return -1;
+
+found:
+	if(type)
+		*type = table->columns[i].type;
+	return i;
 }
 
 
@@ -298,6 +1795,96 @@ ezxml_t ligolw_table_get(ezxml_t elem, const char *name)
 }
 
 
+/*
+ * ligolw_cell_to_c() for the cell of column c of a row.  If the row's
+ * string and blob data is in the table's arena or the document, which keep
+ * it, the destination is given a copy of its own instead, so that in
+ * either case the calling code owns what it receives.
+ */
+
+
+static int table_cell_to_c(const struct ligolw_table *table, const struct ligolw_table_row *row, int c, enum ligolw_cell_type type, void *dest)
+{
+	union ligolw_cell copy;
+
+	if(!table_block_data_shared(table) || !table_row_in_block(table, row))
+		return ligolw_cell_to_c(&row->cells[c], type, dest);
+
+	copy = row->cells[c];
+	switch(type) {
+	case ligolw_cell_type_char_s:
+	case ligolw_cell_type_char_v:
+	case ligolw_cell_type_ilwdchar:
+	case ligolw_cell_type_ilwdchar_u:
+	case ligolw_cell_type_lstring:
+		if(copy.as_string && !(copy.as_string = strdup(copy.as_string)))
+			return -1;
+		break;
+
+	case ligolw_cell_type_blob:
+		if(copy.as_blob.data) {
+			void *data = malloc(copy.as_blob.len ? copy.as_blob.len : 1);
+			if(!data)
+				return -1;
+			copy.as_blob.data = memcpy(data, copy.as_blob.data, copy.as_blob.len);
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	return ligolw_cell_to_c(&copy, type, dest);
+}
+
+
+/*
+ * Check that a type is a string type.
+ */
+
+
+static bool table_type_is_string(enum ligolw_cell_type type)
+{
+	switch(type) {
+	case ligolw_cell_type_char_s:
+	case ligolw_cell_type_char_v:
+	case ligolw_cell_type_ilwdchar:
+	case ligolw_cell_type_ilwdchar_u:
+	case ligolw_cell_type_lstring:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+
+/*
+ * Copy the string in a cell into the char array dest, which has room for
+ * capacity bytes, for a struct ligolw_unpacking_spec with a capacity.  The
+ * cell keeps its data.  Unlike ligolw_cell_string_copy_keep() only the
+ * string's characters and the terminator are written, not the rest of
+ * dest.  Returns the number of characters copied, or < 0 if the column is
+ * not a string.
+ */
+
+
+static int table_cell_to_array(const union ligolw_cell *cell, enum ligolw_cell_type type, char *dest, size_t capacity)
+{
+	const char *txt = cell->as_string ? cell->as_string : "";
+	size_t len;
+
+	if(!table_type_is_string(type))
+		return -1;
+
+	len = strnlen(txt, capacity - 1);
+	memcpy(dest, txt, len);
+	dest[len] = '\0';
+
+	return len;
+}
+
+
 /*
  * Utility to assist with unpacking a table row into alternate storage.
  * NOTE:  this is not a row builder call-back for use with
@@ -320,6 +1907,16 @@ ezxml_t ligolw_table_get(ezxml_t elem, const char *name)
  * data pointers set to NULL, and so it is safe for the calling code to
  * unconditionally call free() on all cell object pointers afterwards, but
  * be aware that that is not necessarily free()'ing all allocated memory.
+ * If the row's data is in the table's arena or borrowed from the document
+ * (see ligolw_table_parse_opts())
+ * the destinations are given copies, which the calling code must free(),
+ * and the cells are left as they are.
+ *
+ * If spec->capacity is not 0, dest is a char array with room for that
+ * many bytes, and the value of the column, which must be a string, is
+ * copied into it, truncated to capacity - 1 characters if it is longer.
+ * The cell keeps its data, and nothing is allocated, so this can be used
+ * with rows of any origin including LIGOLW_TABLE_REUSE_ROW's.
  */
 
 
@@ -348,7 +1945,11 @@ int ligolw_table_unpack_row(struct ligolw_table *table, struct ligolw_table_row
 			 * but is ignored */
 			continue;
 
-		if((size = ligolw_cell_to_c(&row.cells[c], spec->type, spec->dest)) < 0) {
+		if(spec->capacity)
+			size = table_cell_to_array(&row.cells[c], spec->type, spec->dest, spec->capacity);
+		else
+			size = table_cell_to_c(table, &row, c, spec->type, spec->dest);
+		if(size < 0) {
 			/* spec provided an invalid type */
 			return -(spec - data + 1);
 		}
@@ -360,6 +1961,157 @@ int ligolw_table_unpack_row(struct ligolw_table *table, struct ligolw_table_row
 }
 
 
+/*
+ * A struct ligolw_unpacking_spec compiled against a table's columns by
+ * ligolw_unpacking_plan_new().  Destinations are recorded as offsets from
+ * the base address given when the plan was made.
+ */
+
+
+struct ligolw_unpacking_plan {
+	int n_steps;
+	struct ligolw_unpacking_step {
+		int column;
+		enum ligolw_cell_type type;
+		uintptr_t dest;
+		uintptr_t dest_size;
+		bool has_dest_size;
+		/* see struct ligolw_unpacking_spec */
+		size_t capacity;
+	} *steps;
+};
+
+
+/*
+ * Compile an unpacking spec for use with the rows of table.  The names,
+ * types and flags in the spec are checked once, here, as
+ * ligolw_table_unpack_row() checks them for every row, and the columns'
+ * indexes found, so that ligolw_unpacking_plan_apply() involves no
+ * look-ups.  The spec's dest and dest_size addresses are recorded
+ * relative to base, so that a plan made from a spec pointing into one row
+ * structure can be applied to others:  ligolw_unpacking_plan_apply() is
+ * passed the address of the structure to fill in.  base may be NULL, in
+ * which case the addresses are used as they are.
+ *
+ * Returns the plan, which must be freed with ligolw_unpacking_plan_free(),
+ * or NULL on failure.  If error is not NULL, the location it points to is
+ * set to the value ligolw_table_unpack_row() would have returned for the
+ * spec, or 0 if the failure was to allocate memory.
+ */
+
+
+struct ligolw_unpacking_plan *ligolw_unpacking_plan_new(struct ligolw_table *table, const struct ligolw_unpacking_spec *spec, const void *base, int *error)
+{
+	const struct ligolw_unpacking_spec *data = spec;
+	struct ligolw_unpacking_plan *plan;
+	int dummy;
+
+	if(!error)
+		error = &dummy;
+	*error = 0;
+
+	for(; spec->name; spec++);
+	plan = malloc(sizeof(*plan));
+	if(!plan)
+		return NULL;
+	plan->n_steps = 0;
+	plan->steps = malloc((spec - data + 1) * sizeof(*plan->steps));
+	if(!plan->steps) {
+		free(plan);
+		return NULL;
+	}
+
+	for(spec = data; spec->name; spec++) {
+		struct ligolw_unpacking_step *step = &plan->steps[plan->n_steps];
+		enum ligolw_cell_type type;
+		int c = ligolw_table_get_column(table, spec->name, &type);
+		if(c < 0) {
+			/* no column by that name */
+			if(!(spec->flags & LIGOLW_COLUMN_FLAGS_REQUIRED))
+				/* not required */
+				continue;
+			/* missing column is required */
+			*error = spec - data + 1;
+			goto error;
+		}
+		if(spec->type != type) {
+			/* type mismatch */
+			*error = -(spec - data + 1);
+			goto error;
+		}
+		if(!spec->dest)
+			/* column has a valid name and the correct type,
+			 * but is ignored */
+			continue;
+		if(!ligolw_type_enum_to_name(type) || (spec->capacity && !table_type_is_string(type))) {
+			/* spec provided an invalid type */
+			*error = -(spec - data + 1);
+			goto error;
+		}
+
+		step->column = c;
+		step->type = type;
+		step->dest = (uintptr_t) spec->dest - (uintptr_t) base;
+		step->has_dest_size = spec->dest_size != NULL;
+		step->dest_size = (uintptr_t) spec->dest_size - (uintptr_t) base;
+		step->capacity = spec->capacity;
+		plan->n_steps++;
+	}
+
+	return plan;
+
+error:
+	ligolw_unpacking_plan_free(plan);
+	return NULL;
+}
+
+
+/*
+ * Unpack a row using a plan made by ligolw_unpacking_plan_new().  base is
+ * the address of the structure to fill in, in place of the one the plan
+ * was made with (NULL if the plan was made with NULL).  As with
+ * ligolw_table_unpack_row(), ownership of string and blob data is
+ * transfered to the destinations and the cells' pointers set to NULL, or
+ * copies are made if the data is in the table's arena or the document,
+ * and strings are copied into destinations with a capacity.  Returns 0
+ * on success, < 0 on failure.
+ */
+
+
+int ligolw_unpacking_plan_apply(const struct ligolw_unpacking_plan *plan, struct ligolw_table_row *row, void *base)
+{
+	const struct ligolw_unpacking_step *step, *end = plan->steps + plan->n_steps;
+
+	for(step = plan->steps; step < end; step++) {
+		void *dest = (void *) ((uintptr_t) base + step->dest);
+		int size;
+		if(step->capacity)
+			size = table_cell_to_array(&row->cells[step->column], step->type, dest, step->capacity);
+		else
+			size = table_cell_to_c(row->table, row, step->column, step->type, dest);
+		if(size < 0)
+			return -1;
+		if(step->has_dest_size)
+			*(size_t *) ((uintptr_t) base + step->dest_size) = size;
+	}
+
+	return 0;
+}
+
+
+/*
+ * Free an unpacking plan.
+ */
+
+
+void ligolw_unpacking_plan_free(struct ligolw_unpacking_plan *plan)
+{
+	if(plan)
+		free(plan->steps);
+	free(plan);
+}
+
+
 /*
  * Print a struct ligolw_table structure
  */
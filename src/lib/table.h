@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2026  agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include <stdbool.h>
+#include <ezligolw/ezligolw.h>
+
+
+/* see stream.h */
+struct ligolw_stream_token;
+struct ligolw_stream_index;
+
+
+/* a struct ligolw_table_filter compiled against a table's columns */
+struct ligolw_table_filter_prog {
+	/* n_columns flags, true for the columns the filter examines */
+	bool *columns;
+	/* the expression's nodes, the root is first */
+	int n_nodes;
+	struct ligolw_table_filter_node {
+		enum ligolw_table_filter_op op;
+		/* comparisons */
+		int column;
+		enum ligolw_cell_type type;
+		union ligolw_cell value;
+		/* AND and OR:  indexes of the operands' nodes */
+		int a;
+		int b;
+	} *nodes;
+};
+
+
+struct ligolw_table *ligolw_table_new(ezxml_t);
+bool *ligolw_table_selected_columns(const struct ligolw_table *, const struct ligolw_table_options *, bool *);
+int ligolw_table_next_row(const struct ligolw_table *, struct ligolw_stream_index *, const char **, struct ligolw_stream_token *);
+void ligolw_table_free_cells(const struct ligolw_table *, union ligolw_cell *, const bool *);
+
+struct ligolw_table_filter_prog *ligolw_table_filter_compile(const struct ligolw_table *, const struct ligolw_table_filter *);
+void ligolw_table_filter_free(struct ligolw_table_filter_prog *);
+bool ligolw_table_filter_eval(const struct ligolw_table_filter_prog *, const union ligolw_cell *);
@@ -37,7 +37,7 @@ const char *ligolw_time_parse(ezxml_t elem, const char **type)
 		return NULL;
 	}
 	*type = ezxml_attr(elem, "Type");
-	return elem->txt;
+	return ezxml_txt_decode(elem);
 }
 
 
@@ -18,11 +18,14 @@
 
 
 #include <assert.h>
+#include <ctype.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <b64/cdecode.h>
 #include <b64/cencode.h>
+#include <./numeric.h>
 #include <ezligolw/ezligolw.h>
 
 
@@ -131,59 +134,99 @@ size_t ligolw_type_enum_to_size(enum ligolw_cell_type t)
  * the data for string and blob types is decoded and returned copied into a
  * newly allocated buffer.  the calling code owns the memory and must
  * free() it when finished with it.
+ *
+ * numbers are parsed as strtoll() (with base 0), strtoull() and strtod()
+ * in the C locale would parse them, but it is an error for the text to
+ * contain anything else but white space, or for an integer to be out of
+ * range;  the cell is set all the same.  complex numbers are written
+ * "re+iim".  blank text is 0.
  */
 
 
 union ligolw_cell *ligolw_cell_from_txt(union ligolw_cell *cell, enum ligolw_cell_type type, const char *txt)
 {
-	/* FIXME:  implement error checking */
+	return ligolw_cell_from_txtn(cell, type, txt, strlen(txt));
+}
+
+
+/*
+ * Check the result of parsing a number from the text from txt to stop.
+ * end is the value returned by the parser.  Returns cell if all of the
+ * text but white space was the number, or if there was no number and the
+ * text is blank, NULL otherwise.
+ */
+
+
+static union ligolw_cell *ligolw_cell_check_number(union ligolw_cell *cell, const char *txt, const char *end, const char *stop)
+{
+	for(end = end ? end : txt; end < stop && isspace((unsigned char) *end); end++);
+	return end == stop ? cell : NULL;
+}
+
+
+/*
+ * Same as ligolw_cell_from_txt() but the text is given as the address of
+ * its first character and its length, and need not be null-terminated.
+ * For example, a token in the character content of an element parsed with
+ * ezxml_parse_file_ro().
+ */
+
+
+union ligolw_cell *ligolw_cell_from_txtn(union ligolw_cell *cell, enum ligolw_cell_type type, const char *txt, size_t len)
+{
+	const char *stop = txt + len;
+	const char *end;
+
 	switch(type) {
 	case ligolw_cell_type_char_s:
 	case ligolw_cell_type_char_v:
 	case ligolw_cell_type_ilwdchar:
 	case ligolw_cell_type_ilwdchar_u:
 	case ligolw_cell_type_lstring:
-		cell->as_string = strdup(txt);
+		cell->as_string = strndup(txt, len);
 		break;
 
 	case ligolw_cell_type_blob: {
-		size_t n = strlen(txt);
 		base64_decodestate b64state;
 		base64_init_decodestate(&b64state);
-		cell->as_blob.len = n; /*FIXME: base64_decode_maxlength(n)*/
+		cell->as_blob.len = len; /*FIXME: base64_decode_maxlength(n)*/
 		cell->as_blob.data = malloc(cell->as_blob.len);
-		base64_decode_block(txt, n, cell->as_blob.data, &b64state);
+		base64_decode_block(txt, len, cell->as_blob.data, &b64state);
 		break;
 	}
 
 	case ligolw_cell_type_int_2s:
 	case ligolw_cell_type_int_4s:
 	case ligolw_cell_type_int_8s:
-		cell->as_int = strtoll(txt, NULL, 0);
-		break;
+		end = ligolw_parse_int(txt, stop, &cell->as_int);
+		return ligolw_cell_check_number(cell, txt, end, stop);
 
 	case ligolw_cell_type_int_2u:
 	case ligolw_cell_type_int_4u:
 	case ligolw_cell_type_int_8u:
-		cell->as_uint = strtoull(txt, NULL, 0);
-		break;
+		end = ligolw_parse_uint(txt, stop, &cell->as_uint);
+		return ligolw_cell_check_number(cell, txt, end, stop);
 
 	case ligolw_cell_type_real_4:
 	case ligolw_cell_type_real_8:
-		cell->as_double = strtod(txt, NULL);
-		break;
+		/* real_4 is parsed as a double too, and narrowed by
+		 * ligolw_cell_to_c() */
+		end = ligolw_parse_double(txt, stop, &cell->as_double);
+		return ligolw_cell_check_number(cell, txt, end, stop);
 
 	case ligolw_cell_type_complex_8:
 	case ligolw_cell_type_complex_16: {
-		double re, im;
-		char *end;
-		re = strtod(txt, &end);
-		/* skip "+i" */
-		end += 2;
-		im = strtod(end, NULL);
+		double re, im = 0;
+		end = ligolw_parse_double(txt, stop, &re);
+		if(end && stop - end >= 2 && end[0] == '+' && end[1] == 'i')
+			end = ligolw_parse_double(end + 2, stop, &im);
+		else if(end)
+			/* no imaginary part */
+			end = NULL;
 		cell->as_double_complex = re + im * I;
-		break;
+		return ligolw_cell_check_number(cell, txt, end, stop);
 	}
+
 	default:
 		/* unrecognized type enum */
 		return NULL;
@@ -310,6 +353,14 @@ char *ligolw_cell_to_txt(union ligolw_cell cell, enum ligolw_cell_type type)
  * when finished with it.  To reduce the risk of errors, the cell's data
  * pointer is set to NULL.  It is safe for calling code to call free() on
  * the cell's pointer, but doing so has no effect on allocated memory.
+ *
+ * The cell's data must have been allocated for it alone.  The rows of a
+ * table built by the default row builder of ligolw_table_parse(),
+ * ligolw_table_parse_opts() or ligolw_table_parse_parallel() keep their
+ * string and blob data in the table's arena, or with
+ * LIGOLW_TABLE_BORROW_STRINGS in the document, and this function must not
+ * be used on them.  Parse with LIGOLW_TABLE_OWN_STRINGS to get rows whose
+ * data can be taken, as all rows' could be in earlier versions.
  */
 
 
@@ -391,6 +442,12 @@ int ligolw_cell_to_c(union ligolw_cell *cell, enum ligolw_cell_type type, void *
  * must free() the ligolw_cell itself if required.  The ligolw_cell's
  * string pointer is set to NULL, so it is safe for the calling code to
  * call free() on it, but doing so has no effect on allocated memory.
+ *
+ * As with ligolw_cell_to_c(), the string must have been allocated for the
+ * cell alone, which is not the case for the rows of a table built by the
+ * default row builder unless LIGOLW_TABLE_OWN_STRINGS was given:  their
+ * strings belong to the table's arena.  Use
+ * ligolw_cell_string_copy_keep() on those.
  */
 
 
@@ -403,3 +460,20 @@ int ligolw_cell_string_copy(union ligolw_cell *cell, char *dest, size_t len)
 	cell->as_string = NULL;
 	return copied;
 }
+
+
+/*
+ * Same as ligolw_cell_string_copy() but the ligolw_cell keeps its data.
+ * Row call-backs that must work with rows decoded with
+ * LIGOLW_TABLE_REUSE_ROW, whose strings belong to the library, use this
+ * and leave the freeing to ligolw_table_free_row().
+ */
+
+
+int ligolw_cell_string_copy_keep(const union ligolw_cell *cell, char *dest, size_t len)
+{
+	size_t copied;
+	copied = stpncpy(dest, cell->as_string ? cell->as_string : "", len) - dest;
+	dest[len] = '\0';
+	return copied;
+}
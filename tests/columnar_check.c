@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 2026  agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+/*
+ * Check ligolw_columnar_table_parse() and table filters against
+ * ligolw_table_parse_opts().  A Table is generated with integer,
+ * floating-point and string columns, some strings with escape sequences
+ * and delimiters in them, and parsed into columns with and without a
+ * filter, a selection of columns and dictionary encoding.  Every stored
+ * value must be the same as in the rows ligolw_table_parse_opts() builds
+ * with the same options.  Then a Table with an invalid value is parsed,
+ * with and without a filter examining the value's column, and both
+ * parsers must fail.
+ */
+
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ezligolw/ezxml.h>
+#include <ezligolw/ezligolw.h>
+
+
+#define N_ROWS 5000
+
+
+static int n_checked;
+static int n_failed;
+
+
+/*
+ * xorshift64*, so that the document is the same on every run.
+ */
+
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ull;
+
+
+static uint64_t rng(void)
+{
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 0x2545f4914f6cdd1dull;
+}
+
+
+/*
+ * Generate the document.  The caller must free() the result.
+ */
+
+
+static char *generate(size_t *len)
+{
+	static const char *const ifos[] = {"H1", "L1", "V1", "K1"};
+	static const char *const strings[] = {
+		"a",
+		"",
+		"H1,L1",
+		"back\\\\slash",
+		"say \\\"hi\\\"",
+		"x &amp; y &lt; z",
+		",\n\t\t",
+	};
+	const char *head =
+		"<?xml version='1.0' encoding='utf-8'?>\n"
+		"<LIGO_LW>\n"
+		"\t<Table Name=\"t:table\">\n"
+		"\t\t<Column Name=\"id\" Type=\"int_8s\"/>\n"
+		"\t\t<Column Name=\"b\" Type=\"int_4s\"/>\n"
+		"\t\t<Column Name=\"x\" Type=\"real_8\"/>\n"
+		"\t\t<Column Name=\"ifo\" Type=\"lstring\"/>\n"
+		"\t\t<Column Name=\"s\" Type=\"lstring\"/>\n"
+		"\t\t<Stream Name=\"t:table\" Type=\"Local\" Delimiter=\",\">\n";
+	const char *tail =
+		"\t\t</Stream>\n"
+		"\t</Table>\n"
+		"</LIGO_LW>\n";
+	char *txt = malloc(strlen(head) + strlen(tail) + N_ROWS * 128 + 1);
+	char *s = txt;
+	int i;
+
+	if(!txt) {
+		perror("malloc");
+		exit(1);
+	}
+	s = stpcpy(s, head);
+	for(i = 0; i < N_ROWS; i++)
+		s += sprintf(s, "\t\t\t%d,%d,%.17g,\"%s\",\"%s\"%s\n", i, (int) (rng() % 41) - 20, (double) (rng() >> 11) / (1ull << 53), ifos[rng() % 4], strings[rng() % (sizeof(strings) / sizeof(*strings))], i < N_ROWS - 1 ? "," : "");
+	s = stpcpy(s, tail);
+
+	*len = s - txt;
+	return txt;
+}
+
+
+/*
+ * Compare a columnar table to the rows of a table.  Columns that were not
+ * selected must have no data.
+ */
+
+
+static void check_columnar(const char *what, const struct ligolw_columnar_table *columnar, const struct ligolw_table *table, const char *const *selected)
+{
+	int n_bad = 0;
+	int c, i;
+
+	n_checked++;
+	if(columnar->n_rows != table->n_rows || columnar->n_columns != table->n_columns) {
+		fprintf(stderr, "%s:  %d rows of %d columns, expected %d of %d\n", what, columnar->n_rows, columnar->n_columns, table->n_rows, table->n_columns);
+		n_failed++;
+		return;
+	}
+
+	for(c = 0; c < columnar->n_columns; c++) {
+		const struct ligolw_columnar_column *column = &columnar->columns[c];
+		bool wanted = !selected;
+		const char *const *name;
+
+		for(name = selected; name && *name; name++)
+			wanted |= !strcmp(*name, column->name);
+		if(!wanted) {
+			if(column->data || column->offsets || column->lengths || column->codes)
+				n_bad++;
+			continue;
+		}
+
+		for(i = 0; i < columnar->n_rows; i++) {
+			union ligolw_cell cell = table->rows[i].cells[c];
+
+			if(column->offsets) {
+				int j = column->codes ? column->codes[i] : i;
+				const char *value = (const char *) column->data + column->offsets[j];
+				if(strcmp(value, cell.as_string) || column->lengths[j] != strlen(cell.as_string)) {
+					if(n_bad++ < 3)
+						fprintf(stderr, "%s:  row %d column %s is \"%s\", expected \"%s\"\n", what, i, column->name, value, cell.as_string);
+				}
+			} else {
+				/* numeric cells own nothing, so ligolw_cell_to_c()
+				 * can be used on a copy */
+				size_t size = ligolw_type_enum_to_size(column->type);
+				double value[2];
+				ligolw_cell_to_c(&cell, column->type, value);
+				if(memcmp((char *) column->data + i * size, value, size)) {
+					if(n_bad++ < 3)
+						fprintf(stderr, "%s:  row %d column %s differs\n", what, i, column->name);
+				}
+			}
+		}
+	}
+
+	if(n_bad) {
+		fprintf(stderr, "%s:  %d values differ\n", what, n_bad);
+		n_failed++;
+	}
+}
+
+
+/*
+ * Both parsers must fail on a document with an invalid value in a column
+ * they convert.
+ */
+
+
+static void check_invalid(const char *what, ezxml_t elem, const struct ligolw_table_options *options)
+{
+	struct ligolw_columnar_table *columnar = ligolw_columnar_table_parse(elem, options);
+	struct ligolw_table *table = ligolw_table_parse_opts(elem, options, NULL, NULL);
+
+	n_checked++;
+	if(columnar || table) {
+		fprintf(stderr, "%s:  invalid value not reported by%s%s\n", what, columnar ? " ligolw_columnar_table_parse()" : "", table ? " ligolw_table_parse_opts()" : "");
+		n_failed++;
+	}
+	ligolw_columnar_table_free(columnar);
+	ligolw_table_free(table);
+}
+
+
+int main(void)
+{
+	static const char *const some[] = {"b", "ifo", NULL};
+	static const char *const dictionary[] = {"ifo", "s", "x", NULL};
+	struct ligolw_table_filter lt = {LIGOLW_TABLE_FILTER_LT, "b", {.as_int = 10}, NULL, NULL};
+	struct ligolw_table_filter gt = {LIGOLW_TABLE_FILTER_GT, "x", {.as_double = 0.5}, NULL, NULL};
+	struct ligolw_table_filter eq = {LIGOLW_TABLE_FILTER_EQ, "ifo", {.as_string = "H1"}, NULL, NULL};
+	struct ligolw_table_filter and = {LIGOLW_TABLE_FILTER_AND, NULL, {0}, &lt, &gt};
+	struct ligolw_table_filter or = {LIGOLW_TABLE_FILTER_OR, NULL, {0}, &and, &eq};
+	const struct {
+		const char *what;
+		struct ligolw_table_options options;
+	} cases[] = {
+		{"all columns", {NULL, NULL, 0, LIGOLW_TABLE_FLAGS_NONE, 0, NULL}},
+		{"filtered", {NULL, &or, 0, LIGOLW_TABLE_FLAGS_NONE, 0, NULL}},
+		{"some columns", {some, NULL, 0, LIGOLW_TABLE_FLAGS_NONE, 0, NULL}},
+		{"dictionary", {NULL, NULL, 0, LIGOLW_TABLE_FLAGS_NONE, 0, dictionary}},
+		{"some columns, filtered, dictionary", {some, &or, 0, LIGOLW_TABLE_FLAGS_NONE, 0, dictionary}},
+	};
+	size_t len;
+	char *txt = generate(&len);
+	ezxml_t xml = ezxml_parse_str(txt, len);
+	ezxml_t elem = ligolw_table_get(xml, "t");
+	unsigned i;
+
+	if(!elem) {
+		fprintf(stderr, "cannot parse document:  %s\n", xml ? ezxml_error(xml) : "out of memory");
+		return 1;
+	}
+
+	for(i = 0; i < sizeof(cases) / sizeof(*cases); i++) {
+		struct ligolw_columnar_table *columnar = ligolw_columnar_table_parse(elem, &cases[i].options);
+		struct ligolw_table *table = ligolw_table_parse_opts(elem, &cases[i].options, NULL, NULL);
+
+		if(columnar && table)
+			check_columnar(cases[i].what, columnar, table, cases[i].options.columns);
+		else {
+			fprintf(stderr, "%s:  failed\n", cases[i].what);
+			n_checked++;
+			n_failed++;
+		}
+		ligolw_columnar_table_free(columnar);
+		ligolw_table_free(table);
+	}
+
+	ezxml_free(xml);
+	free(txt);
+
+	/* an invalid value in column b, in a row that passes the filters */
+	{
+		char bad[] =
+			"<LIGO_LW>\n"
+			"\t<Table Name=\"t:table\">\n"
+			"\t\t<Column Name=\"a\" Type=\"int_4s\"/>\n"
+			"\t\t<Column Name=\"b\" Type=\"int_4s\"/>\n"
+			"\t\t<Column Name=\"x\" Type=\"real_8\"/>\n"
+			"\t\t<Stream Name=\"t:table\" Type=\"Local\" Delimiter=\",\">\n"
+			"\t\t\t1,abc,0.25,\n"
+			"\t\t\t2,3,0.75\n"
+			"\t\t</Stream>\n"
+			"\t</Table>\n"
+			"</LIGO_LW>\n";
+		struct ligolw_table_filter x_lt = {LIGOLW_TABLE_FILTER_LT, "x", {.as_double = 0.5}, NULL, NULL};
+		struct ligolw_table_options options = {NULL, NULL, 0, LIGOLW_TABLE_FLAGS_NONE, 0, NULL};
+
+		xml = ezxml_parse_str(bad, strlen(bad));
+		elem = ligolw_table_get(xml, "t");
+		if(!elem) {
+			fprintf(stderr, "cannot parse document:  %s\n", xml ? ezxml_error(xml) : "out of memory");
+			return 1;
+		}
+		check_invalid("invalid value", elem, &options);
+		options.filter = &lt;
+		check_invalid("invalid value, filter on its column", elem, &options);
+		options.filter = &x_lt;
+		check_invalid("invalid value, filter on another column", elem, &options);
+		ezxml_free(xml);
+	}
+
+	printf("%d of %d checks failed\n", n_failed, n_checked);
+	return n_failed ? 1 : 0;
+}
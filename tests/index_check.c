@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2026  agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+/*
+ * Check the byte-offset index of a document.  A document is written with
+ * two Tables and a Param in nested LIGO_LW elements, and its index is
+ * built and saved by ligolw_index_open().  The saved index must be the
+ * same as the one built, the elements ligolw_index_load() reads with it
+ * must be the same as those of the whole document, and the index must be
+ * rejected once the document's modification time changes, even within the
+ * same second, or once the index file has been truncated.
+ */
+
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <ezligolw/ezxml.h>
+#include <ezligolw/ezligolw.h>
+
+
+static int n_checked;
+static int n_failed;
+
+
+static void check(const char *what, int ok)
+{
+	n_checked++;
+	if(!ok) {
+		fprintf(stderr, "%s:  failed\n", what);
+		n_failed++;
+	}
+}
+
+
+static const char document[] =
+	"<?xml version='1.0' encoding='utf-8'?>\n"
+	"<!DOCTYPE LIGO_LW SYSTEM \"http://ldas-sw.ligo.caltech.edu/doc/ligolwAPI/html/ligolw_dtd.txt\">\n"
+	"<LIGO_LW>\n"
+	"\t<LIGO_LW Name=\"outer\">\n"
+	"\t\t<Param Name=\"p:param\" Type=\"real_8\">2.5</Param>\n"
+	"\t\t<Table Name=\"process:table\">\n"
+	"\t\t\t<Column Name=\"program\" Type=\"lstring\"/>\n"
+	"\t\t\t<Column Name=\"process_id\" Type=\"int_8s\"/>\n"
+	"\t\t\t<Stream Name=\"process:table\" Type=\"Local\" Delimiter=\",\">\n"
+	"\t\t\t\t\"a &lt;b&gt;\",0,\n"
+	"\t\t\t\t\"c,\\\"d\\\"\",1\n"
+	"\t\t\t</Stream>\n"
+	"\t\t</Table>\n"
+	"\t</LIGO_LW>\n"
+	"\t<Table Name=\"t:table\">\n"
+	"\t\t<Column Name=\"x\" Type=\"real_8\"/>\n"
+	"\t\t<Column Name=\"n\" Type=\"int_4s\"/>\n"
+	"\t\t<Stream Name=\"t:table\" Type=\"Local\" Delimiter=\",\">\n"
+	"\t\t\t0.5,1,\n"
+	"\t\t\t1e-3,-2,\n"
+	"\t\t\t7,3\n"
+	"\t\t</Stream>\n"
+	"\t</Table>\n"
+	"</LIGO_LW>\n";
+
+
+/*
+ * Compare two indexes entry by entry.
+ */
+
+
+static int same_index(const struct ligolw_index *a, const struct ligolw_index *b)
+{
+	int i;
+
+	if(a->size != b->size || a->mtime != b->mtime || a->mtime_nsec != b->mtime_nsec || a->prolog != b->prolog || a->n_entries != b->n_entries)
+		return 0;
+	for(i = 0; i < a->n_entries; i++) {
+		const struct ligolw_index_entry *x = &a->entries[i], *y = &b->entries[i];
+		if(strcmp(x->type, y->type) || !x->name != !y->name || (x->name && strcmp(x->name, y->name)) || x->parent != y->parent || x->offset != y->offset || x->length != y->length || x->head != y->head)
+			return 0;
+	}
+	return 1;
+}
+
+
+/*
+ * Compare two tables' rows.
+ */
+
+
+static int same_table(struct ligolw_table *a, struct ligolw_table *b)
+{
+	int i, c;
+
+	if(!a || !b || a->n_rows != b->n_rows || a->n_columns != b->n_columns)
+		return 0;
+	for(i = 0; i < a->n_rows; i++)
+		for(c = 0; c < a->n_columns; c++) {
+			char *x = ligolw_cell_to_txt(a->rows[i].cells[c], a->columns[c].type);
+			char *y = ligolw_cell_to_txt(b->rows[i].cells[c], b->columns[c].type);
+			int same = x && y && !strcmp(x, y);
+			free(x);
+			free(y);
+			if(!same)
+				return 0;
+		}
+	return 1;
+}
+
+
+/*
+ * Load a Table with the index, and compare it to the whole document's.
+ * If nested is set the Table is in the inner LIGO_LW element.
+ */
+
+
+static void check_table(const struct ligolw_index *index, const char *filename, ezxml_t xml, const char *name, int nested)
+{
+	ezxml_t part = ligolw_index_load(index, filename, "Table", name);
+	struct ligolw_table *a = ligolw_table_parse(ligolw_table_get(nested ? ezxml_child(xml, "LIGO_LW") : xml, name), NULL, NULL);
+	struct ligolw_table *b = ligolw_table_parse(ligolw_table_get(nested ? ezxml_child(part, "LIGO_LW") : part, name), NULL, NULL);
+	char what[64];
+
+	sprintf(what, "loading table %s", name);
+	check(what, part && same_table(a, b));
+	ligolw_table_free(a);
+	ligolw_table_free(b);
+	ezxml_free(part);
+}
+
+
+/*
+ * The offset of the start of a file's last line, or -1 on failure.
+ */
+
+
+static off_t last_line(const char *filename)
+{
+	FILE *f = fopen(filename, "r");
+	off_t offset = 0, last = -1;
+	int c, prev = '\n';
+
+	if(!f)
+		return -1;
+	while((c = getc(f)) != EOF) {
+		if(prev == '\n')
+			last = offset;
+		prev = c;
+		offset++;
+	}
+	fclose(f);
+	return last;
+}
+
+
+int main(void)
+{
+	char filename[64], sidecar[128];
+	struct ligolw_index *index, *saved;
+	struct timespec times[2];
+	struct stat st;
+	ezxml_t xml, part;
+	double value = 0;
+	int fd;
+
+	sprintf(filename, "index_check.%ld.xml", (long) getpid());
+	sprintf(sidecar, "%s.idx", filename);
+	fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if(fd < 0 || write(fd, document, strlen(document)) != (ssize_t) strlen(document) || close(fd)) {
+		perror(filename);
+		return 1;
+	}
+
+	/* build and save the index, and read it back */
+	index = ligolw_index_open(filename);
+	check("building the index", index != NULL);
+	if(!index)
+		goto done;
+	check("indexing every element", index->n_entries == 7);
+	saved = ligolw_index_read(sidecar, filename);
+	check("reading the saved index", saved && same_index(index, saved));
+	ligolw_index_free(saved);
+	saved = ligolw_index_open(filename);
+	check("opening the saved index", saved && same_index(index, saved));
+	ligolw_index_free(saved);
+
+	/* load elements with it */
+	xml = ezxml_parse_file(filename);
+	check("parsing the document", xml != NULL);
+	if(xml) {
+		check_table(index, filename, xml, "process", 1);
+		check_table(index, filename, xml, "t", 0);
+		ezxml_free(xml);
+	}
+	part = ligolw_index_load(index, filename, "Param", "p");
+	check("loading the param", part && ligolw_param_get_as_c(ligolw_param_get(ezxml_child(part, "LIGO_LW"), "p"), &value, ligolw_cell_type_real_8) >= 0 && value == 2.5);
+	ezxml_free(part);
+	check("loading a missing element", !ligolw_index_load(index, filename, "Table", "missing"));
+
+	/* a change to the document's modification time within the same
+	 * second, if the file system records it to the microsecond */
+	if(!stat(filename, &st)) {
+		times[0] = st.st_atim;
+		times[1] = st.st_mtim;
+		times[1].tv_nsec += times[1].tv_nsec < 500000000 ? 1000 : -1000;
+		if(!utimensat(AT_FDCWD, filename, times, 0) && !stat(filename, &st) && st.st_mtim.tv_nsec != index->mtime_nsec) {
+			saved = ligolw_index_read(sidecar, filename);
+			check("rejecting the index of a modified document", !saved);
+			ligolw_index_free(saved);
+			check("loading from a modified document", !ligolw_index_load(index, filename, "Table", "t"));
+			ligolw_index_free(index);
+			index = ligolw_index_open(filename);
+			check("rebuilding the index", index && index->mtime_nsec == st.st_mtim.tv_nsec);
+		}
+	}
+
+	/* an index file truncated by its last entry */
+	if(!truncate(sidecar, last_line(sidecar))) {
+		saved = ligolw_index_read(sidecar, filename);
+		check("rejecting a truncated index", !saved);
+		ligolw_index_free(saved);
+	}
+
+done:
+	ligolw_index_free(index);
+	unlink(sidecar);
+	unlink(filename);
+
+	printf("%d of %d checks failed\n", n_failed, n_checked);
+	return n_failed ? 1 : 0;
+}
@@ -0,0 +1,358 @@
+/*
+ * Copyright (C) 2026  agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+/*
+ * Check ligolw_parse_double(), ligolw_parse_int() and ligolw_parse_uint()
+ * against strtod(), strtoll() and strtoull().  Each text is parsed from a
+ * buffer in which it is followed by more digits, to check that nothing
+ * past the stop address is read, and the value and the number of
+ * characters consumed must be the same as the C library's, bit for bit.
+ * The floating-point texts are checked again with LC_NUMERIC set to a
+ * locale whose decimal point is not '.', if one is installed, and must
+ * give the same results as the C library's in the C locale.
+ */
+
+
+#include <errno.h>
+#include <float.h>
+#include <inttypes.h>
+#include <locale.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <numeric.h>
+
+
+/* the number of random texts of each kind */
+#define N_RANDOM 100000
+
+
+static int n_checked;
+static int n_failed;
+
+
+/* if not NULL, the locale LC_NUMERIC is set to, other than while the C
+ * library's results are found */
+static const char *numeric_locale;
+
+
+/*
+ * xorshift64*, so that the texts are the same on every run.
+ */
+
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ull;
+
+
+static uint64_t rng(void)
+{
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 0x2545f4914f6cdd1dull;
+}
+
+
+/*
+ * Copy txt into buf followed by digits, and return the address of the
+ * copy's end, which is the stop address to parse to.
+ */
+
+
+static const char *unterminated(char *buf, size_t size, const char *txt)
+{
+	size_t len = strlen(txt);
+
+	if(len + 8 > size) {
+		fprintf(stderr, "text too long:  \"%s\"\n", txt);
+		exit(1);
+	}
+	memcpy(buf, txt, len);
+	memcpy(buf + len, "1234567", 8);
+	return buf + len;
+}
+
+
+static void report(const char *what, const char *txt, const char *got, const char *expected)
+{
+	if(++n_failed <= 20)
+		fprintf(stderr, "%s(\"%s\"):  got %s, expected %s\n", what, txt, got, expected);
+}
+
+
+static void check_double(const char *txt)
+{
+	char buf[1024];
+	const char *stop = unterminated(buf, sizeof(buf), txt);
+	char *end;
+	const char *result;
+	double expected, value;
+	uint64_t a, b;
+	long n_expected, n_got;
+
+	if(numeric_locale)
+		setlocale(LC_NUMERIC, "C");
+	expected = strtod(txt, &end);
+	if(numeric_locale)
+		setlocale(LC_NUMERIC, numeric_locale);
+	n_expected = end == txt ? -1 : end - txt;
+	result = ligolw_parse_double(buf, stop, &value);
+	n_got = result ? result - buf : -1;
+
+	memcpy(&a, &value, sizeof(a));
+	memcpy(&b, &expected, sizeof(b));
+	n_checked++;
+	/* NaNs need only both be NaNs with the same sign */
+	if(n_got != n_expected || (value == value ? a != b : expected == expected || (a ^ b) >> 63)) {
+		char got_s[64], expected_s[64];
+		sprintf(got_s, "%a (%ld chars)", value, n_got);
+		sprintf(expected_s, "%a (%ld chars)", expected, n_expected);
+		report("ligolw_parse_double", txt, got_s, expected_s);
+	}
+}
+
+
+static void check_int(const char *txt)
+{
+	char buf[1024];
+	const char *stop = unterminated(buf, sizeof(buf), txt);
+	char *end;
+	const char *result;
+	int64_t expected, value;
+	long n_expected, n_got;
+
+	errno = 0;
+	expected = strtoll(txt, &end, 0);
+	n_expected = end == txt || errno == ERANGE ? -1 : end - txt;
+	result = ligolw_parse_int(buf, stop, &value);
+	n_got = result ? result - buf : -1;
+
+	n_checked++;
+	if(n_got != n_expected || value != expected) {
+		char got_s[64], expected_s[64];
+		sprintf(got_s, "%" PRId64 " (%ld chars)", value, n_got);
+		sprintf(expected_s, "%" PRId64 " (%ld chars)", expected, n_expected);
+		report("ligolw_parse_int", txt, got_s, expected_s);
+	}
+}
+
+
+static void check_uint(const char *txt)
+{
+	char buf[1024];
+	const char *stop = unterminated(buf, sizeof(buf), txt);
+	char *end;
+	const char *result;
+	uint64_t expected, value;
+	long n_expected, n_got;
+
+	errno = 0;
+	expected = strtoull(txt, &end, 0);
+	n_expected = end == txt || errno == ERANGE ? -1 : end - txt;
+	result = ligolw_parse_uint(buf, stop, &value);
+	n_got = result ? result - buf : -1;
+
+	n_checked++;
+	if(n_got != n_expected || value != expected) {
+		char got_s[64], expected_s[64];
+		sprintf(got_s, "%" PRIu64 " (%ld chars)", value, n_got);
+		sprintf(expected_s, "%" PRIu64 " (%ld chars)", expected, n_expected);
+		report("ligolw_parse_uint", txt, got_s, expected_s);
+	}
+}
+
+
+static void check_integer(const char *txt)
+{
+	check_int(txt);
+	check_uint(txt);
+}
+
+
+static const char *const double_texts[] = {
+	/* zeros */
+	"0", "-0", "+0", "0.0", "-0.0", "0e999999", "-0e-999999", ".0", "0.",
+	"00000000000000000000000000000000000000", "0.0000000000000000000000001e400",
+	/* malformed, or not numbers at all */
+	"", "-", "+", ".", "-.", "e5", ".e5", "1e", "1e+", "1e-", "1.5e+x",
+	"123abc", "  12", "\t-3.5", "1..2", "--1", "+-1", "1e5.5", "0x", "0x1p3",
+	"-0x1.8p-2", "0X10",
+	/* infinities and NaNs */
+	"inf", "-inf", "+INF", "infinity", "-Infinity", "infinit", "nan",
+	"-nan", "NAN", "nan(123)", "nan(", "in",
+	/* classic hard cases */
+	"9007199254740993", "9007199254740992.5", "9007199254740993.0000000001",
+	"9007199254740994", "9007199254740995", "18014398509481985",
+	"2.2250738585072011e-308", "2.2250738585072012e-308",
+	"2.2250738585072014e-308", "2.225073858507201136057409796709131975934819546351645648e-308",
+	"4.9406564584124654e-324", "2.4703282292062327e-324",
+	"2.4703282292062328e-324", "2.4703282292062327208828439643411068618252990130716238221279284125033775363510437593264991818081799618989828234772285886546332835517796989819938739800539093906315035659515570226392290858392449105184435931802849936536152500319370457678249219365623669863658480757001585769269903706311928279558551332927834338409351978015531246597263579574622766465272827220056374006485499977096599470454020828166226237857393450736339007967761930577506740176324673600968951340535537458516661134223766678604162159680461914467291840300530057530849048765391711386591646239524912623653881879636239373280423891018672348497668235089863388587925628302755995657524455507255189313690836254779186948667994968324049705821028513185451396213837722826145437693412532098591327667236328125e-324",
+	"1e-320", "1e-323", "1e-324", "3e-324", "1e-400",
+	"1.7976931348623157e308", "1.7976931348623158e308",
+	"1.7976931348623159e308", "1e308", "1e309", "1e400", "-1e400",
+	"0.1", "0.2", "0.3", "1.1", "3.14159265358979323846",
+	"123456789012345678901234567890", "1234567890123456789",
+	"12345678901234567890", "0.000000000000000000000000000000000001234",
+	"1e23", "8.41e21", "5e-324", "9.999999999999999e22",
+	"7.038531e-26", "1448997445238699", "1.00000000000000011102230246251565404236316680908203125",
+	"1.00000000000000011102230246251565404236316680908203124",
+	"1.00000000000000011102230246251565404236316680908203126",
+	"0.500000000000000166533453693773481063544750213623046875",
+	"3.518437208883201171875e13", "62.5364939768271845828",
+	"8.10109172351e-10", "1.50000000000000011102230246251565404236316680908203125",
+	"9007199254740991.4999999999999999999999999999999995",
+	NULL
+};
+
+
+static const char *const integer_texts[] = {
+	"0", "-0", "+0", "", "-", "+", " 42", "\t-42", "42x", "--1", "+-1",
+	"1", "-1", "010", "-010", "08", "0x1f", "0X1F", "-0x10", "0x", "0xg",
+	"999999999999999999", "1000000000000000000", "-1000000000000000000",
+	"9223372036854775806", "9223372036854775807", "9223372036854775808",
+	"9223372036854775809", "-9223372036854775807", "-9223372036854775808",
+	"-9223372036854775809", "-9223372036854775810",
+	"18446744073709551614", "18446744073709551615", "18446744073709551616",
+	"18446744073709551619", "18446744073709551620", "19999999999999999999",
+	"20000000000000000000", "99999999999999999999", "100000000000000000000",
+	"-18446744073709551615", "-18446744073709551616",
+	"00000000000000000000000000000001", "0000000000000000000000000000000",
+	"12345678901234567890123",
+	NULL
+};
+
+
+int main(void)
+{
+	char txt[1024];
+	int i;
+
+	for(i = 0; double_texts[i]; i++)
+		check_double(double_texts[i]);
+	for(i = 0; integer_texts[i]; i++)
+		check_integer(integer_texts[i]);
+
+	/* random doubles, printed with enough digits to round-trip and with
+	 * too few or too many */
+	for(i = 0; i < N_RANDOM; i++) {
+		static const char *const formats[] = {"%.17g", "%.16g", "%.15g", "%.6e", "%.25e", "%.3f"};
+		uint64_t bits = rng();
+		double x;
+		memcpy(&x, &bits, sizeof(x));
+		sprintf(txt, formats[i % 6], x);
+		check_double(txt);
+	}
+
+	/* random subnormals */
+	for(i = 0; i < N_RANDOM / 10; i++) {
+		uint64_t bits = rng() & (((uint64_t) 1 << 52) - 1);
+		double x;
+		memcpy(&x, &bits, sizeof(x));
+		sprintf(txt, "%.17g", x);
+		check_double(txt);
+	}
+
+#if LDBL_MANT_DIG > DBL_MANT_DIG
+	/* values exactly half way between two adjacent doubles, and just
+	 * either side of half way.  the midpoint is exact in long double,
+	 * and is printed in full */
+	for(i = 0; i < N_RANDOM / 10; i++) {
+		uint64_t bits = rng() & ~((uint64_t) 1 << 63), next_bits = bits + 1;
+		double x, next;
+		long double mid;
+		memcpy(&x, &bits, sizeof(x));
+		memcpy(&next, &next_bits, sizeof(next));
+		if(!(next - x < DBL_MAX))
+			/* infinity or NaN */
+			continue;
+		mid = ((long double) x + next) / 2;
+		if(i % 2)
+			/* the exact midpoint */
+			snprintf(txt, sizeof(txt) - 8, "%.*Le", (int) (sizeof(txt) - 40), mid);
+		else
+			/* within rounding of it */
+			sprintf(txt, "%.*Le", 17 + (int) (rng() % 10), mid);
+		check_double(txt);
+	}
+#endif
+
+	/* random digit strings with a decimal point and an exponent */
+	for(i = 0; i < N_RANDOM; i++) {
+		int n = 1 + rng() % 25, point = rng() % (n + 1), j;
+		char *s = txt;
+		if(rng() % 2)
+			*s++ = '-';
+		for(j = 0; j < n; j++) {
+			if(j == point)
+				*s++ = '.';
+			*s++ = '0' + rng() % 10;
+		}
+		if(rng() % 4)
+			s += sprintf(s, "e%d", (int) (rng() % 680) - 350);
+		*s = '\0';
+		check_double(txt);
+	}
+
+	/* random integers of every length, and near the limits */
+	for(i = 0; i < N_RANDOM; i++) {
+		int n = 1 + rng() % 21, j;
+		char *s = txt;
+		if(rng() % 2)
+			*s++ = '-';
+		*s++ = '1' + rng() % 9;
+		for(j = 1; j < n; j++)
+			*s++ = '0' + rng() % 10;
+		*s = '\0';
+		check_integer(txt);
+	}
+	for(i = -1000; i <= 1000; i++) {
+		sprintf(txt, "%" PRIu64, (uint64_t) INT64_MAX + i);
+		check_integer(txt);
+		sprintf(txt, "-%" PRIu64, (uint64_t) INT64_MAX + i);
+		check_integer(txt);
+		sprintf(txt, "%" PRIu64, UINT64_MAX - 1000 + (i + 1000) / 2);
+		check_integer(txt);
+	}
+
+	/* again with a decimal comma, for the texts left to the C library:
+	 * the fixed ones, long digit strings and subnormals */
+	{
+		static const char *const locales[] = {"de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8", "fr_FR.utf8", "ru_RU.UTF-8", "ru_RU.utf8", NULL};
+		for(i = 0; locales[i] && !numeric_locale; i++)
+			if(setlocale(LC_NUMERIC, locales[i]) && strcmp(localeconv()->decimal_point, "."))
+				numeric_locale = locales[i];
+	}
+	if(numeric_locale) {
+		for(i = 0; double_texts[i]; i++)
+			check_double(double_texts[i]);
+		for(i = 0; i < N_RANDOM / 10; i++) {
+			uint64_t bits = rng() & (((uint64_t) 1 << 52) - 1);
+			double x;
+			memcpy(&x, &bits, sizeof(x));
+			sprintf(txt, i % 2 ? "%.17g" : "%.25e", x);
+			check_double(txt);
+		}
+		setlocale(LC_NUMERIC, "C");
+	} else
+		printf("no locale with a decimal comma is installed, not checking parsing in one\n");
+
+	printf("%d of %d checks failed\n", n_failed, n_checked);
+	return n_failed ? 1 : 0;
+}
@@ -0,0 +1,403 @@
+/*
+ * Copyright (C) 2026  agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+/*
+ * Check ligolw_table_parse_parallel() against ligolw_table_parse_opts().
+ * A Table is generated whose Stream is long enough to be split into
+ * several chunks, with escape sequences and entities in its strings, and
+ * with long strings full of text that looks like the ends of rows, so that
+ * chunk boundaries falling inside them are guessed wrong and must be
+ * re-parsed.  The Table is parsed with one thread and with several, with
+ * and without a filter, building the table, with and without
+ * LIGOLW_TABLE_BORROW_STRINGS, and passing blocks of rows to a call-back
+ * in order and unordered, and every row must be the same as the serial
+ * parser's.
+ */
+
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ezligolw/ezxml.h>
+#include <ezligolw/ezligolw.h>
+
+
+/* the number of rows, and the number of rows between long strings */
+#define N_ROWS 100000
+#define LONG_STRING_INTERVAL 2500
+
+
+static int n_checked;
+static int n_failed;
+
+
+/*
+ * xorshift64*, so that the document is the same on every run.
+ */
+
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ull;
+
+
+static uint64_t rng(void)
+{
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 0x2545f4914f6cdd1dull;
+}
+
+
+/*
+ * A growing buffer for the document's text.
+ */
+
+
+struct buffer {
+	char *txt;
+	size_t len;
+	size_t size;
+};
+
+
+static void append(struct buffer *buf, const char *txt)
+{
+	size_t len = strlen(txt);
+
+	if(buf->len + len + 1 > buf->size) {
+		buf->size = 2 * (buf->len + len + 1);
+		buf->txt = realloc(buf->txt, buf->size);
+		if(!buf->txt) {
+			perror("realloc");
+			exit(1);
+		}
+	}
+	memcpy(buf->txt + buf->len, txt, len + 1);
+	buf->len += len;
+}
+
+
+/*
+ * Append the text of a string value, as it appears in the Stream, quotes
+ * and all.  Most are short, some with delimiters, escape sequences or
+ * entities in them.  Every LONG_STRING_INTERVAL'th is tens or hundreds of
+ * kilobytes of text that looks like the ends of rows:  delimiters followed
+ * by new-lines, escaped quotes followed by delimiters and new-lines, and
+ * whole rows.
+ */
+
+
+static void append_string(struct buffer *buf, int row)
+{
+	static const char *const shorts[] = {
+		"a",
+		"short",
+		"H1,L1",
+		"a\\\\b",
+		"say \\\"hi\\\"",
+		"x &amp; y &lt; z",
+		"",
+		",\n\t\t",
+	};
+	static const char *const pieces[] = {
+		",\n\t\t",
+		"\\\",\n\t\t",
+		"7,0.5,\\\"fake\\\",3,\n\t\t",
+		"8,0.25,fake,4,\n\t\t",
+		"\\\\,\n",
+		"\\\\\\\",\n\t\t",
+		"text ",
+		"\\&quot;,\n\t\t",
+	};
+
+	append(buf, "\"");
+	if(row % LONG_STRING_INTERVAL == LONG_STRING_INTERVAL / 2) {
+		size_t stop = buf->len + 20000 + rng() % 300000;
+		while(buf->len < stop)
+			append(buf, pieces[rng() % (sizeof(pieces) / sizeof(*pieces))]);
+	} else
+		append(buf, shorts[rng() % (sizeof(shorts) / sizeof(*shorts))]);
+	append(buf, "\"");
+}
+
+
+/*
+ * Generate the document.  Roughly half of the Stream's text is in the
+ * long strings, so several of the chunk boundaries fall in them.
+ */
+
+
+static char *generate(size_t *len)
+{
+	struct buffer buf = {NULL, 0, 0};
+	char txt[128];
+	int i;
+
+	append(&buf,
+		"<?xml version='1.0' encoding='utf-8'?>\n"
+		"<LIGO_LW>\n"
+		"\t<Table Name=\"t:table\">\n"
+		"\t\t<Column Name=\"id\" Type=\"int_8s\"/>\n"
+		"\t\t<Column Name=\"x\" Type=\"real_8\"/>\n"
+		"\t\t<Column Name=\"s\" Type=\"lstring\"/>\n"
+		"\t\t<Column Name=\"n\" Type=\"int_4s\"/>\n"
+		"\t\t<Stream Name=\"t:table\" Type=\"Local\" Delimiter=\",\">\n"
+	);
+	for(i = 0; i < N_ROWS; i++) {
+		sprintf(txt, "\t\t\t%" PRId64 ",%.17g,", (int64_t) (rng() >> 1) - INT64_MAX / 2, (double) (rng() >> 11) / (1ull << 53));
+		append(&buf, txt);
+		append_string(&buf, i);
+		sprintf(txt, ",%d%s\n", (int) (rng() % 2001) - 1000, i < N_ROWS - 1 ? "," : "");
+		append(&buf, txt);
+	}
+	append(&buf,
+		"\t\t</Stream>\n"
+		"\t</Table>\n"
+		"</LIGO_LW>\n"
+	);
+
+	*len = buf.len;
+	return buf.txt;
+}
+
+
+/*
+ * The text of a row's cells, for comparing rows.  The return value is a
+ * newly allocated buffer, or NULL if an error occurs.
+ */
+
+
+static char *row_txt(const struct ligolw_table *table, const union ligolw_cell *cells)
+{
+	char *txt = NULL;
+	size_t len = 0;
+	int i;
+
+	for(i = 0; i < table->n_columns; i++) {
+		char *cell = ligolw_cell_to_txt(cells[i], table->columns[i].type);
+		char *new;
+		if(!cell) {
+			free(txt);
+			return NULL;
+		}
+		new = realloc(txt, len + strlen(cell) + 2);
+		if(!new) {
+			free(cell);
+			free(txt);
+			return NULL;
+		}
+		txt = new;
+		len += sprintf(txt + len, "%s%s", i ? "\t" : "", cell);
+		free(cell);
+	}
+	return txt;
+}
+
+
+/*
+ * The rows of a table built by the library.
+ */
+
+
+static char **table_rows(const struct ligolw_table *table)
+{
+	char **rows = calloc(table->n_rows, sizeof(*rows));
+	int i;
+
+	for(i = 0; rows && i < table->n_rows; i++)
+		rows[i] = row_txt(table, table->rows[i].cells);
+	return rows;
+}
+
+
+static void free_rows(char **rows, int n_rows)
+{
+	int i;
+
+	for(i = 0; rows && i < n_rows; i++)
+		free(rows[i]);
+	free(rows);
+}
+
+
+/*
+ * Compare rows to the reference rows, and report the first few that
+ * differ.
+ */
+
+
+static void check_rows(const char *what, char **ref, int n_ref, char **rows, int n_rows)
+{
+	int n_bad = 0;
+	int i;
+
+	n_checked++;
+	if(n_rows != n_ref) {
+		fprintf(stderr, "%s:  %d rows, expected %d\n", what, n_rows, n_ref);
+		n_failed++;
+		return;
+	}
+	for(i = 0; i < n_rows; i++)
+		if(!rows || !rows[i] || !ref[i] || strcmp(rows[i], ref[i])) {
+			if(n_bad++ < 3)
+				fprintf(stderr, "%s:  row %d is \"%s\", expected \"%s\"\n", what, i, rows && rows[i] ? rows[i] : "(null)", ref[i] ? ref[i] : "(null)");
+		}
+	if(n_bad) {
+		fprintf(stderr, "%s:  %d rows differ\n", what, n_bad);
+		n_failed++;
+	}
+}
+
+
+/*
+ * Batch call-back collecting the text of each row at its index.  In order,
+ * each block must start where the last one ended.
+ */
+
+
+struct collection {
+	pthread_mutex_t lock;
+	int ordered;
+	char **rows;
+	int size;
+	int n_rows;
+	int next_row;
+	int failed;
+};
+
+
+static int collect(struct ligolw_table *table, struct ligolw_table_batch *batch, void *data)
+{
+	struct collection *collection = data;
+	int failed;
+	int i;
+
+	pthread_mutex_lock(&collection->lock);
+	if(collection->ordered && batch->first_row != collection->next_row)
+		collection->failed = 1;
+	collection->next_row = batch->first_row + batch->n_rows;
+	collection->n_rows += batch->n_rows;
+	if(batch->first_row < 0 || batch->first_row + batch->n_rows > collection->size)
+		collection->failed = 1;
+	failed = collection->failed;
+	pthread_mutex_unlock(&collection->lock);
+	if(failed)
+		return -1;
+
+	for(i = 0; i < batch->n_rows; i++) {
+		char **row = &collection->rows[batch->first_row + i];
+		if(*row)
+			return -1;
+		*row = row_txt(table, batch->rows[i].cells);
+		if(!*row)
+			return -1;
+	}
+	return 0;
+}
+
+
+int main(void)
+{
+	static const int n_threads[] = {1, 2, 7};
+	struct ligolw_table_filter lt = {LIGOLW_TABLE_FILTER_LT, "x", {.as_double = 0.3}, NULL, NULL};
+	struct ligolw_table_filter eq = {LIGOLW_TABLE_FILTER_EQ, "s", {.as_string = "H1,L1"}, NULL, NULL};
+	struct ligolw_table_filter or = {LIGOLW_TABLE_FILTER_OR, NULL, {0}, &lt, &eq};
+	size_t len;
+	char *txt = generate(&len);
+	ezxml_t xml = ezxml_parse_str(txt, len);
+	ezxml_t elem = ligolw_table_get(xml, "t");
+	int filtered;
+
+	if(!elem) {
+		fprintf(stderr, "cannot parse document:  %s\n", xml ? ezxml_error(xml) : "out of memory");
+		return 1;
+	}
+
+	for(filtered = 0; filtered < 2; filtered++) {
+		struct ligolw_table_options options = {NULL, filtered ? &or : NULL, 0, LIGOLW_TABLE_FLAGS_NONE, 0, NULL};
+		struct ligolw_table *ref = ligolw_table_parse_opts(elem, &options, NULL, NULL);
+		char **ref_rows;
+		unsigned i;
+
+		if(!ref) {
+			fprintf(stderr, "ligolw_table_parse_opts() failed\n");
+			return 1;
+		}
+		ref_rows = table_rows(ref);
+
+		for(i = 0; i < sizeof(n_threads) / sizeof(*n_threads); i++) {
+			struct ligolw_table *table;
+			char what[64];
+			int borrow;
+			int ordered;
+
+			options.n_threads = n_threads[i];
+			options.batch_size = 0;
+
+			/* LIGOLW_TABLE_BORROW_STRINGS is ignored, and must
+			 * leave the text as it was for the runs that follow */
+			for(borrow = 0; borrow < 2; borrow++) {
+				options.flags = borrow ? LIGOLW_TABLE_BORROW_STRINGS : LIGOLW_TABLE_FLAGS_NONE;
+
+				sprintf(what, "%d thread(s)%s, table%s", n_threads[i], filtered ? ", filtered" : "", borrow ? ", borrowing" : "");
+				table = ligolw_table_parse_parallel(elem, &options, NULL, NULL);
+				if(table) {
+					char **rows = table_rows(table);
+					check_rows(what, ref_rows, ref->n_rows, rows, table->n_rows);
+					free_rows(rows, table->n_rows);
+					ligolw_table_free(table);
+				} else {
+					fprintf(stderr, "%s:  failed\n", what);
+					n_checked++;
+					n_failed++;
+				}
+			}
+
+			for(ordered = 0; ordered < 2; ordered++) {
+				struct collection collection = {PTHREAD_MUTEX_INITIALIZER, ordered, calloc(ref->n_rows, sizeof(char *)), ref->n_rows, 0, 0, 0};
+
+				options.batch_size = 113;
+				options.flags = ordered ? LIGOLW_TABLE_FLAGS_NONE : LIGOLW_TABLE_UNORDERED;
+
+				sprintf(what, "%d thread(s)%s, %s", n_threads[i], filtered ? ", filtered" : "", ordered ? "ordered" : "unordered");
+				table = ligolw_table_parse_parallel(elem, &options, collect, &collection);
+				if(table && !collection.failed)
+					check_rows(what, ref_rows, ref->n_rows, collection.rows, collection.n_rows);
+				else {
+					fprintf(stderr, "%s:  failed\n", what);
+					n_checked++;
+					n_failed++;
+				}
+				free_rows(collection.rows, ref->n_rows);
+				ligolw_table_free(table);
+			}
+		}
+
+		free_rows(ref_rows, ref->n_rows);
+		ligolw_table_free(ref);
+	}
+
+	ezxml_free(xml);
+	free(txt);
+
+	printf("%d of %d checks failed\n", n_failed, n_checked);
+	return n_failed ? 1 : 0;
+}